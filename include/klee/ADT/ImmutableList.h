@@ -0,0 +1,194 @@
+//===-- ImmutableList.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_IMMUTABLELIST_H
+#define KLEE_IMMUTABLELIST_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace klee {
+  /// A list that can only grow at its end and whose copies share their
+  /// elements. Copying is O(1), appending to a copy never changes any other
+  /// copy. The elements are stored in chunks: a list appends in place as long
+  /// as it is the only owner of its last chunk, otherwise it starts a new chunk
+  /// that refers to the shared prefix.
+  template<class T>
+  class ImmutableList {
+    struct Chunk;
+    /// the chunks of a list from its first to its last chunk
+    typedef std::vector<const Chunk *> spine_ty;
+
+    struct Chunk {
+      std::shared_ptr<Chunk> prev;
+      /// number of elements of the prefix that belong to this chunk's list
+      std::size_t prevSize;
+      std::vector<T> values;
+      /// the chunks up to this one, built by the first iteration that ends in
+      /// this chunk. The predecessors of a chunk never change, so the spine
+      /// stays valid while values are appended.
+      mutable std::unique_ptr<spine_ty> spine;
+
+      Chunk(std::shared_ptr<Chunk> _prev, std::size_t _prevSize)
+        : prev(std::move(_prev)), prevSize(_prevSize) {}
+
+      const spine_ty &getSpine() const {
+        if (!spine) {
+          // start from the spine of the closest predecessor that has one
+          spine_ty missing;
+          const Chunk *c = this;
+          for (; c && !c->spine; c = c->prev.get())
+            missing.push_back(c);
+
+          spine.reset(c ? new spine_ty(*c->spine) : new spine_ty());
+          spine->reserve(spine->size() + missing.size());
+          spine->insert(spine->end(), missing.rbegin(), missing.rend());
+        }
+        return *spine;
+      }
+    };
+
+    std::shared_ptr<Chunk> last;
+    std::size_t count = 0;
+
+  public:
+    typedef T value_type;
+
+    /// Iterates over the chunks of the list's spine, it does not allocate.
+    class iterator {
+      friend class ImmutableList;
+
+      const spine_ty *spine = nullptr;
+      std::size_t size = 0;
+      std::size_t chunk = 0;
+      std::size_t index = 0;
+      std::size_t position;
+
+      explicit iterator(std::size_t _position) : position(_position) {}
+
+      /// \return the number of elements of the chunk that belong to the list
+      std::size_t chunkSize(std::size_t c) const {
+        std::size_t end =
+            c + 1 < spine->size() ? (*spine)[c + 1]->prevSize : size;
+        return end - (*spine)[c]->prevSize;
+      }
+
+      void skipEmptyChunks() {
+        while (chunk < spine->size() && index == chunkSize(chunk)) {
+          ++chunk;
+          index = 0;
+        }
+      }
+
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef T value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const T *pointer;
+      typedef const T &reference;
+
+      iterator() : position(0) {}
+
+      reference operator*() const { return (*spine)[chunk]->values[index]; }
+      pointer operator->() const { return &**this; }
+
+      iterator &operator++() {
+        ++index;
+        ++position;
+        skipEmptyChunks();
+        return *this;
+      }
+      iterator operator++(int) {
+        iterator result = *this;
+        ++*this;
+        return result;
+      }
+
+      bool operator==(const iterator &b) const { return position == b.position; }
+      bool operator!=(const iterator &b) const { return position != b.position; }
+    };
+
+    typedef iterator const_iterator;
+
+    ImmutableList() = default;
+    ImmutableList(const ImmutableList &b) = default;
+    ImmutableList(ImmutableList &&b) = default;
+    ImmutableList &operator=(const ImmutableList &b) = default;
+    ImmutableList &operator=(ImmutableList &&b) = default;
+
+    ~ImmutableList() {
+      // release the chunks only this list refers to one by one, destroying a
+      // long chain recursively could exhaust the stack
+      while (last && last.use_count() == 1) {
+        std::shared_ptr<Chunk> prev = std::move(last->prev);
+        last = std::move(prev);
+      }
+    }
+
+    bool empty() const { return count == 0; }
+    std::size_t size() const { return count; }
+
+    void push_back(T value) {
+      // the last chunk may hold elements beyond a truncated list's end
+      if (!last || last.use_count() > 1 ||
+          last->prevSize + last->values.size() != count)
+        last = std::make_shared<Chunk>(last, count);
+      last->values.push_back(std::move(value));
+      ++count;
+    }
+
+    template<class... Args>
+    void emplace_back(Args &&... args) {
+      push_back(T(std::forward<Args>(args)...));
+    }
+
+    /// Keeps the first n elements. The prefix stays shared with the copies
+    /// of the list, only the chunks after it are released.
+    void truncate(std::size_t n) {
+      assert(n <= count && "cannot grow a list by truncating it");
+      while (last && last->prevSize >= n) {
+        std::shared_ptr<Chunk> prev = last->prev;
+        last = std::move(prev);
+      }
+      count = n;
+      if (last && last.use_count() == 1)
+        last->values.erase(last->values.begin() + (n - last->prevSize),
+                           last->values.end());
+    }
+
+    /// The first call after the list got a new last chunk collects the
+    /// chunks, which takes time linear in their number. Further calls take
+    /// constant time.
+    iterator begin() const {
+      if (!last)
+        return end();
+
+      iterator it(0);
+      it.spine = &last->getSpine();
+      it.size = count;
+      it.skipEmptyChunks();
+      return it;
+    }
+
+    iterator end() const { return iterator(count); }
+
+    bool operator==(const ImmutableList &b) const {
+      return count == b.count &&
+             (last == b.last || std::equal(begin(), end(), b.begin()));
+    }
+    bool operator!=(const ImmutableList &b) const { return !(*this == b); }
+  };
+}
+
+#endif /* KLEE_IMMUTABLELIST_H */
@@ -95,6 +95,10 @@ namespace klee {
     iterator upper_bound(const key_type &key) const { 
       return elts.upper_bound(key); 
     }
+    template<class Pred>
+    iterator partition_point(Pred pred) const {
+      return elts.partition_point(pred);
+    }
 
     static size_t getAllocated() { return Tree::allocated; }
   };
@@ -10,6 +10,7 @@
 #ifndef KLEE_IMMUTABLETREE_H
 #define KLEE_IMMUTABLETREE_H
 
+#include <atomic>
 #include <cassert>
 #include <vector>
 
@@ -17,7 +18,7 @@ namespace klee {
   template<class K, class V, class KOV, class CMP>
   class ImmutableTree {
   public:
-    static size_t allocated;
+    static std::atomic<size_t> allocated;
     class iterator;
 
     typedef K key_type;
@@ -57,6 +58,12 @@ namespace klee {
     iterator lower_bound(const key_type &key) const;
     iterator upper_bound(const key_type &key) const;
 
+    // find the first value pred does not hold for, or end if it holds for
+    // all values. pred must hold for a prefix of the values in key order,
+    // it is only evaluated for the values on one path from the root.
+    template<class Pred>
+    iterator partition_point(Pred pred) const;
+
     static size_t getAllocated() { return allocated; }
 
   private:
@@ -241,7 +248,7 @@ namespace klee {
   ImmutableTree<K,V,KOV,CMP>::Node::terminator;
 
   template<class K, class V, class KOV, class CMP> 
-  size_t ImmutableTree<K,V,KOV,CMP>::allocated = 0;
+  std::atomic<size_t> ImmutableTree<K,V,KOV,CMP>::allocated(0);
 
   template<class K, class V, class KOV, class CMP>
   ImmutableTree<K,V,KOV,CMP>::Node::Node() 
@@ -272,12 +279,15 @@ namespace klee {
 
   template<class K, class V, class KOV, class CMP>
   inline void ImmutableTree<K,V,KOV,CMP>::Node::decref() {
+    // the terminator is shared by all trees, possibly of different threads
+    if (isTerminator()) return;
     --references;
     if (references==0) delete this;
   }
 
   template<class K, class V, class KOV, class CMP>
   inline typename ImmutableTree<K,V,KOV,CMP>::Node *ImmutableTree<K,V,KOV,CMP>::Node::incref() {
+    if (isTerminator()) return this;
     ++references;
     return this;
   }
@@ -615,6 +625,23 @@ namespace klee {
     return it;
   }
 
+  template<class K, class V, class KOV, class CMP>
+  template<class Pred>
+  typename ImmutableTree<K,V,KOV,CMP>::iterator
+  ImmutableTree<K,V,KOV,CMP>::partition_point(Pred pred) const {
+    Node *n = node;
+    Node *result = 0;
+    while (!n->isTerminator()) {
+      if (pred(n->value)) {
+        n = n->right;
+      } else {
+        result = n;
+        n = n->left;
+      }
+    }
+    return result ? lower_bound(key_of_value()(result->value)) : end();
+  }
+
 }
 
 #endif /* KLEE_IMMUTABLETREE_H */
@@ -0,0 +1,143 @@
+//===-- PagedArray.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PAGEDARRAY_H
+#define KLEE_PAGEDARRAY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace klee {
+  /// A fixed size array whose copies share their contents. The elements are
+  /// stored in reference counted pages of PageSize elements, copying the
+  /// array only copies the page references. A page is copied on the first
+  /// write to it while it is still referenced by another array (or by
+  /// another position of the same array), so writing to a copy never changes
+  /// any other copy and only duplicates the pages actually written. The
+  /// pages and their reference counts are allocated with Allocator.
+  template<class T, unsigned PageSize = 4096,
+           class Allocator = std::allocator<T>>
+  class PagedArray {
+    typedef std::vector<T, Allocator> Page;
+
+    std::vector<std::shared_ptr<Page>> pages;
+    unsigned count;
+
+    Page &getWriteablePage(unsigned index) {
+      std::shared_ptr<Page> &page = pages[index];
+      if (page.use_count() > 1)
+        page = std::allocate_shared<Page>(Allocator(), *page);
+      return *page;
+    }
+
+  public:
+    explicit PagedArray(unsigned size, const T &value = T()) : count(size) {
+      fill(value);
+    }
+
+    PagedArray(const PagedArray &b) = default;
+    PagedArray &operator=(const PagedArray &b) = default;
+
+    unsigned size() const { return count; }
+
+    const T &operator[](unsigned idx) const {
+      return (*pages[idx / PageSize])[idx % PageSize];
+    }
+
+    void set(unsigned idx, T value) {
+      getWriteablePage(idx / PageSize)[idx % PageSize] = std::move(value);
+    }
+
+    /// Sets all elements to value. All full pages share a single page until
+    /// they are written.
+    void fill(const T &value) {
+      pages.clear();
+      pages.reserve((count + PageSize - 1) / PageSize);
+
+      std::shared_ptr<Page> full;
+      for (unsigned base = 0; base < count; base += PageSize) {
+        if (count - base < PageSize) {
+          pages.push_back(
+              std::allocate_shared<Page>(Allocator(), count - base, value));
+        } else {
+          if (!full)
+            full = std::allocate_shared<Page>(Allocator(), PageSize, value);
+          pages.push_back(full);
+        }
+      }
+    }
+
+    /// Copies all elements to dst.
+    void copyTo(T *dst) const {
+      for (const auto &page : pages)
+        dst = std::copy(page->begin(), page->end(), dst);
+    }
+
+    /// \return true if the elements are equal to the ones at src
+    bool equals(const T *src) const {
+      for (const auto &page : pages) {
+        if (!std::equal(page->begin(), page->end(), src))
+          return false;
+        src += page->size();
+      }
+      return true;
+    }
+
+    /// Replaces the elements by the ones at src. Pages whose contents do not
+    /// change stay shared.
+    void assign(const T *src) {
+      for (unsigned i = 0; i < pages.size(); ++i) {
+        unsigned pageSize = pages[i]->size();
+        if (!std::equal(pages[i]->begin(), pages[i]->end(), src))
+          std::copy(src, src + pageSize, getWriteablePage(i).begin());
+        src += pageSize;
+      }
+    }
+  };
+
+  /// An array of Bits wide unsigned values with the sharing of a PagedArray,
+  /// a page holds the values of PageSize consecutive indices. Setting a value
+  /// to the one it already has does not copy its page.
+  template<unsigned Bits, unsigned PageSize = 4096,
+           class Allocator = std::allocator<uint32_t>>
+  class PagedPackedArray {
+    static_assert(Bits < 32 && 32 % Bits == 0,
+                  "values must not straddle words");
+
+    static const unsigned PerWord = 32 / Bits;
+    static const uint32_t Mask = (1u << Bits) - 1;
+
+    PagedArray<uint32_t, PageSize / PerWord, Allocator> words;
+
+    static unsigned length(unsigned size) {
+      return (size + PerWord - 1) / PerWord;
+    }
+    static unsigned shift(unsigned idx) { return (idx % PerWord) * Bits; }
+
+  public:
+    explicit PagedPackedArray(unsigned size, unsigned value = 0)
+      : words(length(size), (value & Mask) * (UINT32_MAX / Mask)) {}
+
+    unsigned get(unsigned idx) const {
+      return (words[idx / PerWord] >> shift(idx)) & Mask;
+    }
+    void set(unsigned idx, unsigned value) {
+      uint32_t word = words[idx / PerWord];
+      uint32_t updated =
+          (word & ~(Mask << shift(idx))) | ((value & Mask) << shift(idx));
+      if (updated != word)
+        words.set(idx / PerWord, updated);
+    }
+  };
+}
+
+#endif /* KLEE_PAGEDARRAY_H */
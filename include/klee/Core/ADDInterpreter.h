@@ -12,18 +12,30 @@ namespace klee {
 
     class ExecutionState;
 
+    class ADDInterpreterHandler {
+    public:
+        virtual ~ADDInterpreterHandler() {}
+
+        /// Called as soon as the symbolic execution of a single path is finished,
+        /// so results can be written out before the remaining paths of the function are executed.
+        virtual void processPath(FunctionEvaluation *functionEvaluation, Path *path) = 0;
+    };
+
     class ADDInterpreter {
     public:
         virtual ~ADDInterpreter() {}
 
         virtual void runFunction(FunctionEvaluation *functionEvaluation) = 0;
 
+        /// Symbolically executes a single path of the function and passes it to the handler.
+        virtual void runPath(FunctionEvaluation *functionEvaluation, Path *path) = 0;
+
         virtual llvm::Module *setModule(
                 std::vector<std::unique_ptr<llvm::Module>> &modules,
                 const Interpreter::ModuleOptions &opts
         ) = 0;
 
-        static ADDInterpreter *create(llvm::LLVMContext &context);
+        static ADDInterpreter *create(llvm::LLVMContext &context, ADDInterpreterHandler *handler = nullptr);
     };
 
 }
@@ -10,6 +10,7 @@
 
 #include <klee/Expr/Constraints.h>
 #include <klee/Core/Types.h>
+#include <klee/System/Time.h>
 
 
 namespace klee {
@@ -24,6 +25,8 @@ namespace klee {
 
         std::string repr;
 
+        time::Span symexTime;
+
     public:
         Path();
 
@@ -41,8 +44,14 @@ namespace klee {
 
         VariableExpressionMap &getSymbolicValues();
 
+        void releaseResults();
+
         std::string getPathRepr();
 
+        void setSymexTime(time::Span span);
+
+        time::Span getSymexTime();
+
         llvm::BasicBlock *front();
 
         llvm::BasicBlock *back();
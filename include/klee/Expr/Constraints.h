@@ -10,19 +10,22 @@
 #ifndef KLEE_CONSTRAINTS_H
 #define KLEE_CONSTRAINTS_H
 
+#include "klee/ADT/ImmutableList.h"
 #include "klee/Expr/Expr.h"
 
 namespace klee {
 
 /// Resembles a set of constraints that can be passed around
 ///
+/// Copies share their constraints, so copying a set (e.g. when a state forks)
+/// is O(1) and adding a constraint to a copy does not copy the others.
 class ConstraintSet {
   friend class ConstraintManager;
 
 public:
   using constraints_ty = std::vector<ref<Expr>>;
-  using iterator = constraints_ty::iterator;
-  using const_iterator = constraints_ty::const_iterator;
+  using iterator = ImmutableList<ref<Expr>>::iterator;
+  using const_iterator = ImmutableList<ref<Expr>>::const_iterator;
 
   using constraint_iterator = const_iterator;
 
@@ -31,7 +34,10 @@ public:
   constraint_iterator end() const;
   size_t size() const noexcept;
 
-  explicit ConstraintSet(constraints_ty cs) : constraints(std::move(cs)) {}
+  explicit ConstraintSet(const constraints_ty &cs) {
+    for (const auto &e : cs)
+      constraints.push_back(e);
+  }
   ConstraintSet() = default;
 
   void push_back(const ref<Expr> &e);
@@ -41,7 +47,7 @@ public:
   }
 
 private:
-  constraints_ty constraints;
+  ImmutableList<ref<Expr>> constraints;
 };
 
 class ExprVisitor;
@@ -1004,8 +1004,15 @@ public:
 private:
   llvm::APInt value;
 
+  /// Values below this are shared for the usual widths instead of being
+  /// allocated for every result, concrete code mostly computes with them.
+  static const uint64_t numSmallValues = 256;
+
   ConstantExpr(const llvm::APInt &v) : value(v) {}
 
+  /// \return the shared constant, null if w is not a usual width
+  static ConstantExpr *getSmall(Width w, uint64_t v);
+
 public:
   ~ConstantExpr() {}
 
@@ -1066,6 +1073,11 @@ public:
   void toMemory(void *address);
 
   static ref<ConstantExpr> alloc(const llvm::APInt &v) {
+    if (v.getBitWidth() <= Int64 && v.getZExtValue() < numSmallValues) {
+      if (ConstantExpr *small = getSmall(v.getBitWidth(), v.getZExtValue()))
+        return small;
+    }
+
     ref<ConstantExpr> r(new ConstantExpr(v));
     r->computeHash();
     return r;
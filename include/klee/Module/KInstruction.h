@@ -42,6 +42,14 @@ namespace klee {
     /// Destination register index.
     unsigned dest;
 
+    /// Opcode of the instruction, decoded once so that dispatching does not
+    /// have to touch the LLVM instruction.
+    unsigned opcode;
+
+    /// Width in bits of the value the instruction produces, 0 if it does not
+    /// produce a sized value.
+    unsigned width;
+
   public:
     virtual ~KInstruction();
     std::string getSourceLocation() const;
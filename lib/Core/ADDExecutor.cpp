@@ -9,7 +9,10 @@
 #include <klee/Support/ModuleUtil.h>
 #include <llvm/Support/Path.h>
 #include <klee/Support/ErrorHandling.h>
+#include <klee/Support/Timer.h>
+#include <klee/Statistics/Statistics.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/ADT/StringExtras.h>
 #include <iostream>
 #include "ADDExecutor.h"
 #include "SpecialFunctionHandler.h"
@@ -17,16 +20,18 @@
 #include "ExecutionState.h"
 #include "klee/Core/FunctionEvaluation.h"
 #include "GetElementPtrTypeIterator.h"
+#include "klee/Solver/SolverCmdLine.h"
 // #include <llvm/IR/GetElementPtrTypeIterator.h>
 
 
 namespace klee {
 
-    ADDInterpreter *ADDInterpreter::create(llvm::LLVMContext &context) {
-        return new ADDExecutor(context);
+    ADDInterpreter *ADDInterpreter::create(llvm::LLVMContext &context, ADDInterpreterHandler *handler) {
+        return new ADDExecutor(context, handler);
     }
 
-    ADDExecutor::ADDExecutor(llvm::LLVMContext &context) {
+    ADDExecutor::ADDExecutor(llvm::LLVMContext &context, ADDInterpreterHandler *handler) {
+        this->handler = handler;
         this->externalDispatcher = new ExternalDispatcher(context);
         this->memory = new MemoryManager(&this->arrayCache);
 
@@ -47,60 +52,86 @@ namespace klee {
         this->solver = new TimingSolver(solverChain, true);
     }
 
+    ADDExecutor::~ADDExecutor() {
+        delete this->solver;
+        delete this->memory;
+        delete this->externalDispatcher;
+    }
+
     void ADDExecutor::runFunction(FunctionEvaluation *functionEvaluation) {
         llvm::Function *function = functionEvaluation->getFunction();
         KFunction *kFunction = this->kleeModule->functionMap[function];
 
         for (Path *path : functionEvaluation->getPathList()) {
-            auto *state = new ExecutionState(kFunction);
+            this->executePath(functionEvaluation, kFunction, path);
+            this->finishPath(functionEvaluation, path);
+        }
+    }
 
-            this->initializeGlobals(*state);
-            this->bindModuleConstants();
+    void ADDExecutor::runPath(FunctionEvaluation *functionEvaluation, Path *path) {
+        KFunction *kFunction = this->kleeModule->functionMap[functionEvaluation->getFunction()];
 
-            this->createArguments(function, kFunction, state);
-            this->runAllocas(kFunction, state);
+        this->executePath(functionEvaluation, kFunction, path);
+        this->finishPath(functionEvaluation, path);
+    }
 
-            // run path without allocas (if it has any)
-            // at branches, fork into two states and pick the one on our path as the new current state
-            for (auto blockInPathIt = path->begin(); blockInPathIt != path->end(); blockInPathIt++) {
-                if ((blockInPathIt + 1) == path->end() && !path->shouldExecuteFinishBlock()) {
-                    break;
-                }
+    void ADDExecutor::executePath(FunctionEvaluation *functionEvaluation, KFunction *kFunction, Path *path) {
+        WallTimer pathTimer;
+        auto *state = new ExecutionState(kFunction);
 
-                llvm::BasicBlock *block = *blockInPathIt;
-                // todo sbuescher what if path start is phi block?
-                this->transferToBasicBlock(block, nullptr, *state);
+        this->initializeGlobals(*state);
+        this->bindConstantTable();
 
-                for (llvm::Instruction &instruction : *block) {
-                    KInstruction *ki = state->pc;
-                    this->stepInstruction(*state);
+        this->createArguments(functionEvaluation->getFunction(), kFunction, state);
+        this->runAllocas(kFunction, state);
 
-                    this->executeInstruction(*state, ki, functionEvaluation, kFunction, blockInPathIt);
-                }
+        // run path without allocas (if it has any)
+        // at branches, fork into two states and pick the one on our path as the new current state
+        for (auto blockInPathIt = path->begin(); blockInPathIt != path->end(); blockInPathIt++) {
+            if ((blockInPathIt + 1) == path->end() && !path->shouldExecuteFinishBlock()) {
+                break;
             }
 
-            path->setConstraints(state->constraints);
-            this->addSymbolicValuesToPath(*state, functionEvaluation, path);
+            llvm::BasicBlock *block = *blockInPathIt;
+            // todo sbuescher what if path start is phi block?
+            this->transferToBasicBlock(block, nullptr, *state);
+
+            for (llvm::Instruction &instruction : *block) {
+                KInstruction *ki = state->pc;
+                this->stepInstruction(*state);
+
+                this->executeInstruction(*state, ki, functionEvaluation, kFunction, blockInPathIt);
+            }
+        }
 
-            std::cout << "PATH FINISHED: ["
-                      << path->getPathRepr()
-                      << "] ["
-                      << (path->shouldExecuteFinishBlock() ? "execute last" : "dont execute last")
-                      << "]"
-                      << std::endl;
+        path->setConstraints(state->constraints);
+        this->addSymbolicValuesToPath(*state, functionEvaluation, path);
+        path->setSymexTime(pathTimer.delta());
+    }
 
-            // hack to clear memory objects
-            delete this->memory;
-            this->memory = new MemoryManager(&this->arrayCache);
+    void ADDExecutor::finishPath(FunctionEvaluation *functionEvaluation, Path *path) {
+        std::cout << "PATH FINISHED: ["
+                  << path->getPathRepr()
+                  << "] ["
+                  << (path->shouldExecuteFinishBlock() ? "execute last" : "dont execute last")
+                  << "]"
+                  << std::endl;
 
-            this->globalObjects.clear();
-            this->globalAddresses.clear();
+        if (this->handler) {
+            this->handler->processPath(functionEvaluation, path);
         }
+
+        // hack to clear memory objects
+        delete this->memory;
+        this->memory = new MemoryManager(&this->arrayCache);
+
+        this->globalObjects.clear();
+        this->globalAddresses.clear();
     }
 
     llvm::Module *ADDExecutor::setModule(std::vector<std::unique_ptr<llvm::Module>> &modules,
                                          const Interpreter::ModuleOptions &opts) {
-        this->kleeModule = std::unique_ptr<KModule>(new KModule());
+        this->kleeModule = std::make_shared<KModule>();
 
         /*llvm::SmallString<128> libPath(opts.LibraryDir);
         llvm::sys::path::append(libPath, "libkleeRuntimeIntrinsic" + opts.OptSuffix + ".bca");
@@ -129,6 +160,8 @@ namespace klee {
         llvm::DataLayout *dataLayout = this->kleeModule->targetData.get();
         Context::initialize(dataLayout->isLittleEndian(), (Expr::Width) dataLayout->getPointerSizeInBits());
 
+        this->bindModuleConstants();
+
         return this->kleeModule->module.get();
     }
 
@@ -178,7 +211,7 @@ namespace klee {
         for (unsigned int i = 0; i < kFunction->numInstructions; i++) {
             KInstruction *ki = kFunction->instructions[i];
 
-            if (ki->inst->getOpcode() == llvm::Instruction::Alloca) {
+            if (ki->opcode == llvm::Instruction::Alloca) {
                 auto *allocaInst = cast<llvm::AllocaInst>(ki->inst);
 
                 llvm::Type *type = allocaInst->getAllocatedType();
@@ -243,11 +276,11 @@ namespace klee {
     }
 
     Cell &ADDExecutor::getArgumentCell(ExecutionState &state, KFunction *kf, unsigned index) {
-        return state.stack.back().locals[kf->getArgRegister(index)];
+        return state.stack.back().getWritableLocal(kf->getArgRegister(index));
     }
 
     Cell &ADDExecutor::getDestCell(ExecutionState &state, KInstruction *target) {
-        return state.stack.back().locals[target->dest];
+        return state.stack.back().getWritableLocal(target->dest);
     }
 
     const Cell &ADDExecutor::eval(KInstruction *ki, unsigned operatorIndex, ExecutionState &state) const {
@@ -259,11 +292,11 @@ namespace klee {
         // Determine if this is a constant or not.
         if (varNumber < 0) {
             unsigned index = -varNumber - 2;
-            return this->kleeModule->constantTable[index];
+            return this->constantTable[index];
         } else {
             unsigned index = varNumber;
             StackFrame &sf = state.stack.back();
-            return sf.locals[index];
+            return sf.getLocal(index);
         }
     }
 
@@ -282,39 +315,81 @@ namespace klee {
                                    size_t allocationAlignment) {
         size = this->toUnique(state, size);
 
-        if (auto *constantExpr = dyn_cast<ConstantExpr>(size)) {
-            const llvm::Value *allocSite = state.prevPC->inst;
-
-            if (allocationAlignment == 0) {
-                allocationAlignment = this->getAllocationAlignment(allocSite);
-            }
+        const llvm::Value *allocSite = state.prevPC->inst;
+        if (allocationAlignment == 0) {
+            allocationAlignment = this->getAllocationAlignment(allocSite);
+        }
 
+        if (auto *constantExpr = dyn_cast<ConstantExpr>(size)) {
             MemoryObject *memoryObject = this->memory->allocate(constantExpr->getZExtValue(), isLocal, false, allocSite,
                                                                 allocationAlignment);
-            if (!memoryObject) {
-                this->bindLocal(target, state, ConstantExpr::alloc(0, Context::get().getPointerWidth()));
+            this->bindAllocation(state, memoryObject, isLocal, target, zeroMemory, reallocFrom);
 
-            } else {
-                ObjectState *objectState = this->bindObjectInState(state, memoryObject, isLocal);
+        } else {
+            // there is only one state per path, so the size is bounded by the capacity instead of forking
+            uint64_t capacity = MemoryManager::getSymbolicSizeCapacity();
+            ref<Expr> bounded = UleExpr::create(size, ConstantExpr::create(capacity, size->getWidth()));
+
+            bool mayBeBounded = false;
+            this->solver->setTimeout(this->coreSolverTimeout);
+            bool success = capacity != 0 &&
+                           this->solver->mayBeTrue(state.constraints, bounded, mayBeBounded, state.queryMetaData);
+            this->solver->setTimeout(time::Span());
 
-                if (zeroMemory) {
-                    objectState->initializeToZero();
-                } else {
-                    objectState->initializeToRandom();
-                }
+            if (success && mayBeBounded) {
+                state.constraints.push_back(bounded);
 
-                this->bindLocal(target, state, memoryObject->getBaseExpr());
+                MemoryObject *memoryObject = this->memory->allocateSymbolicSize(
+                        ZExtExpr::create(size, Context::get().getPointerWidth()), isLocal, allocSite,
+                        allocationAlignment);
+                this->bindAllocation(state, memoryObject, isLocal, target, zeroMemory, reallocFrom);
+                return;
+            }
 
-                if (reallocFrom) {
-                    unsigned count = std::min(reallocFrom->size, objectState->size);
-                    for (unsigned i = 0; i < count; i++)
-                        objectState->write(i, reallocFrom->read8(i));
-                    state.addressSpace.unbindObject(reallocFrom->getObject());
-                }
+            // the size cannot stay symbolic, so the path continues with one of its possible sizes
+            ref<ConstantExpr> example;
+            if (!this->solver->getValue(state.constraints, size, example, state.queryMetaData)) {
+                klee_error("unable to find a value for a symbolic allocation size in %s",
+                           state.stack.back().kf->function->getName().str().c_str());
             }
+            klee_warning("symbolic allocation size does not fit the symbolic size capacity of %lu bytes, "
+                         "concretizing it to %lu", (unsigned long) capacity,
+                         (unsigned long) example->getZExtValue());
+
+            state.constraints.push_back(EqExpr::create(size, example));
 
+            MemoryObject *memoryObject = this->memory->allocate(example->getZExtValue(), isLocal, false, allocSite,
+                                                                allocationAlignment);
+            this->bindAllocation(state, memoryObject, isLocal, target, zeroMemory, reallocFrom);
+        }
+    }
+
+    void ADDExecutor::bindAllocation(ExecutionState &state,
+                                     MemoryObject *memoryObject,
+                                     bool isLocal,
+                                     KInstruction *target,
+                                     bool zeroMemory,
+                                     const ObjectState *reallocFrom) {
+        if (!memoryObject) {
+            this->bindLocal(target, state, ConstantExpr::alloc(0, Context::get().getPointerWidth()));
+            return;
+        }
+
+        ObjectState *objectState = this->bindObjectInState(state, memoryObject, isLocal);
+
+        if (zeroMemory) {
+            objectState->initializeToZero();
         } else {
-            assert(false && "alloca of symbolic size not implemented");
+            objectState->initializeToRandom();
+        }
+
+        this->bindLocal(target, state, memoryObject->getBaseExpr());
+
+        if (reallocFrom) {
+            unsigned count = std::min(reallocFrom->size, objectState->size);
+            for (unsigned i = 0; i < count; i++)
+                objectState->write(i, reallocFrom->read8(i));
+            state.addressSpace.unbindObject(reallocFrom->getObject());
         }
     }
 
@@ -323,7 +398,7 @@ namespace klee {
                                              ref<Expr> address,
                                              ref<Expr> value /* undef if read */,
                                              KInstruction *target /* undef if write */) {
-        Expr::Width type = (isWrite ? value->getWidth() : getWidthForLLVMType(target->inst->getType()));
+        Expr::Width type = (isWrite ? value->getWidth() : target->width);
         unsigned bytes = Expr::getMinBytesForWidth(type);
 
         address = this->optimizer.optimizeExpr(address, true);
@@ -409,9 +484,10 @@ namespace klee {
         unsigned id = 0;
         std::string uniqueName = name;
 
-        while (!state.arrayNames.insert(uniqueName).second) {
+        while (state.arrayNames.count(uniqueName)) {
             uniqueName = name + "_" + llvm::utostr(++id);
         }
+        state.arrayNames = state.arrayNames.insert(uniqueName);
 
         const Array *array = this->arrayCache.CreateArray(uniqueName, memoryObject->size);
         this->bindObjectInState(state, memoryObject, false, array);
@@ -424,7 +500,7 @@ namespace klee {
         unsigned entry = kFunction->basicBlockEntry[dst];
         state.pc = &kFunction->instructions[entry];
 
-        if (state.pc->inst->getOpcode() == llvm::Instruction::PHI) {
+        if (state.pc->opcode == llvm::Instruction::PHI) {
             auto *first = static_cast<llvm::PHINode *>(state.pc->inst);
             state.incomingBBIndex = first->getBasicBlockIndex(src);
         }
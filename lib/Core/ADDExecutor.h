@@ -28,8 +28,9 @@
 namespace klee {
     class ADDExecutor : public ADDInterpreter {
     private:
-        std::unique_ptr<KModule> kleeModule;
+        std::shared_ptr<KModule> kleeModule;
 
+        ADDInterpreterHandler *handler;
         ExternalDispatcher *externalDispatcher;
         MemoryManager *memory;
         TimingSolver *solver;
@@ -40,19 +41,31 @@ namespace klee {
         std::map<const llvm::GlobalValue *, MemoryObject *> globalObjects;
         std::map<const llvm::GlobalValue *, ref<ConstantExpr> > globalAddresses;
 
+        /// The constants of the module, evaluated against the global addresses of the current path.
+        std::unique_ptr<Cell[]> constantTable;
+
         time::Span coreSolverTimeout;
 
     public:
-        explicit ADDExecutor(llvm::LLVMContext &context);
+        ADDExecutor(llvm::LLVMContext &context, ADDInterpreterHandler *handler);
+
+        ~ADDExecutor() override;
 
         void runFunction(FunctionEvaluation *functionEvaluation) override;
 
+        void runPath(FunctionEvaluation *functionEvaluation, Path *path) override;
+
         llvm::Module *setModule(
                 std::vector<std::unique_ptr<llvm::Module>> &modules,
                 const Interpreter::ModuleOptions &opts
         ) override;
 
     private:
+        void executePath(FunctionEvaluation *functionEvaluation, KFunction *kFunction, Path *path);
+
+        void finishPath(FunctionEvaluation *functionEvaluation, Path *path);
+
+
         // initializations
 
         void initializeGlobals(ExecutionState &state);
@@ -74,6 +87,8 @@ namespace klee {
 
         void bindModuleConstants();
 
+        void bindConstantTable();
+
         void bindInstructionConstants(KInstruction *kInstruction);
 
         MemoryObject *addExternalObject(ExecutionState &state, void *address, unsigned size, bool isReadOnly);
@@ -154,6 +169,15 @@ namespace klee {
                 size_t allocationAlignment = 0
         );
 
+        void bindAllocation(
+                ExecutionState &state,
+                MemoryObject *memoryObject,
+                bool isLocal,
+                KInstruction *target,
+                bool zeroMemory,
+                const ObjectState *reallocFrom
+        );
+
         void executeMemoryOperation(
                 ExecutionState &state,
                 bool isWrite,
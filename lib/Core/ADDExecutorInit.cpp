@@ -258,10 +258,12 @@ namespace klee {
             for (unsigned i = 0; i < kFunction->numInstructions; ++i)
                 this->bindInstructionConstants(kFunction->instructions[i]);
         }
+    }
 
-        this->kleeModule->constantTable = std::unique_ptr<Cell[]>(new Cell[this->kleeModule->constants.size()]);
+    void ADDExecutor::bindConstantTable() {
+        this->constantTable = std::unique_ptr<Cell[]>(new Cell[this->kleeModule->constants.size()]);
         for (unsigned i = 0; i < this->kleeModule->constants.size(); ++i) {
-            Cell &c = this->kleeModule->constantTable[i];
+            Cell &c = this->constantTable[i];
             c.value = this->evalConstant(this->kleeModule->constants[i]);
         }
     }
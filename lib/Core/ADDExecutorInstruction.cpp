@@ -21,7 +21,7 @@ namespace klee {
                                          KFunction *kFunction,
                                          std::vector<llvm::BasicBlock *>::iterator blockInPathIt) {
         llvm::Instruction *instruction = kInstruction->inst;
-        switch (instruction->getOpcode()) {
+        switch (kInstruction->opcode) {
             // Control flow
             case llvm::Instruction::Ret: {
                 auto *ri = cast<llvm::ReturnInst>(instruction);
@@ -404,37 +404,32 @@ namespace klee {
             }
 
             case llvm::Instruction::Trunc: {
-                auto *ci = cast<llvm::CastInst>(instruction);
                 ref<Expr> result = ExtractExpr::create(this->eval(kInstruction, 0, state).value,
                                                        0,
-                                                       this->getWidthForLLVMType(ci->getType()));
+                                                       kInstruction->width);
                 this->bindLocal(kInstruction, state, result);
                 break;
             }
             case llvm::Instruction::ZExt: {
-                auto *ci = cast<llvm::CastInst>(instruction);
                 ref<Expr> result = ZExtExpr::create(this->eval(kInstruction, 0, state).value,
-                                                    this->getWidthForLLVMType(ci->getType()));
+                                                    kInstruction->width);
                 this->bindLocal(kInstruction, state, result);
                 break;
             }
             case llvm::Instruction::SExt: {
-                auto *ci = cast<llvm::CastInst>(instruction);
                 ref<Expr> result = SExtExpr::create(this->eval(kInstruction, 0, state).value,
-                                                    this->getWidthForLLVMType(ci->getType()));
+                                                    kInstruction->width);
                 this->bindLocal(kInstruction, state, result);
                 break;
             }
             case llvm::Instruction::IntToPtr: {
-                auto *ci = cast<llvm::CastInst>(instruction);
-                Expr::Width pType = this->getWidthForLLVMType(ci->getType());
+                Expr::Width pType = kInstruction->width;
                 ref<Expr> arg = this->eval(kInstruction, 0, state).value;
                 this->bindLocal(kInstruction, state, ZExtExpr::create(arg, pType));
                 break;
             }
             case llvm::Instruction::PtrToInt: {
-                auto *ci = cast<llvm::CastInst>(instruction);
-                Expr::Width iType = this->getWidthForLLVMType(ci->getType());
+                Expr::Width iType = kInstruction->width;
                 ref<Expr> arg = this->eval(kInstruction, 0, state).value;
                 this->bindLocal(kInstruction, state, ZExtExpr::create(arg, iType));
                 break;
@@ -494,7 +489,7 @@ namespace klee {
                 ref<Expr> agg = this->eval(kInstruction, 0, state).value;
 
                 ref<Expr> result = ExtractExpr::create(agg, kgepi->offset * 8,
-                                                       getWidthForLLVMType(instruction->getType()));
+                                                       kInstruction->width);
 
                 this->bindLocal(kInstruction, state, result);
                 break;
@@ -9,6 +9,7 @@
 
 #include "AddressSpace.h"
 
+#include "Context.h"
 #include "ExecutionState.h"
 #include "Memory.h"
 #include "TimingSolver.h"
@@ -18,23 +19,124 @@
 
 #include "CoreStats.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 using namespace klee;
 
 ///
 
+namespace {
+/// Chunks of the index are split once they grow beyond twice this size.
+const std::size_t IndexChunkSize = 64;
+} // namespace
+
+const AddressSpace::Index &AddressSpace::getIndex() const {
+  if (!index) {
+    index = std::make_shared<Index>();
+    for (const auto &object : objects) {
+      if (index->chunks.empty() ||
+          index->chunks.back()->size() == IndexChunkSize)
+        index->chunks.push_back(std::make_shared<IndexChunk>());
+      index->chunks.back()->push_back(
+          {object.first->address, object.first, object.second.get()});
+    }
+  }
+  return *index;
+}
+
+std::size_t AddressSpace::findChunk(const Index &index, uint64_t address) {
+  auto it = std::upper_bound(
+      index.chunks.begin(), index.chunks.end(), address,
+      [](uint64_t a, const std::shared_ptr<IndexChunk> &chunk) {
+        return a < chunk->front().address;
+      });
+  return it == index.chunks.begin() ? 0 : it - index.chunks.begin() - 1;
+}
+
+const AddressSpace::IndexEntry *
+AddressSpace::lookupPrevious(uint64_t address) const {
+  const Index &entries = getIndex();
+  if (entries.chunks.empty())
+    return nullptr;
+
+  const IndexChunk &chunk = *entries.chunks[findChunk(entries, address)];
+  auto it = std::upper_bound(
+      chunk.begin(), chunk.end(), address,
+      [](uint64_t a, const IndexEntry &e) { return a < e.address; });
+  return it == chunk.begin() ? nullptr : &*(it - 1);
+}
+
+AddressSpace::Index *AddressSpace::getOwnIndex() {
+  // only the list of chunks is copied, the chunks stay shared
+  if (index.use_count() > 1)
+    index = std::make_shared<Index>(*index);
+  return index.get();
+}
+
+AddressSpace::IndexChunk &AddressSpace::getOwnChunk(std::size_t position) {
+  std::shared_ptr<IndexChunk> &chunk = index->chunks[position];
+  if (chunk.use_count() > 1)
+    chunk = std::make_shared<IndexChunk>(*chunk);
+  return *chunk;
+}
+
+void AddressSpace::updateIndex(const MemoryObject *mo, const ObjectState *os) {
+  if (!getOwnIndex())
+    return;
+  if (index->chunks.empty()) {
+    index->chunks.push_back(
+        std::make_shared<IndexChunk>(1, IndexEntry{mo->address, mo, os}));
+    return;
+  }
+
+  std::size_t position = findChunk(*index, mo->address);
+  IndexChunk &chunk = getOwnChunk(position);
+  auto it = std::lower_bound(
+      chunk.begin(), chunk.end(), mo->address,
+      [](const IndexEntry &e, uint64_t a) { return e.address < a; });
+  if (it != chunk.end() && it->address == mo->address) {
+    it->mo = mo;
+    it->os = os;
+    return;
+  }
+
+  chunk.insert(it, {mo->address, mo, os});
+  if (chunk.size() > 2 * IndexChunkSize) {
+    auto upper = std::make_shared<IndexChunk>(chunk.begin() + IndexChunkSize,
+                                              chunk.end());
+    chunk.erase(chunk.begin() + IndexChunkSize, chunk.end());
+    index->chunks.insert(index->chunks.begin() + position + 1, upper);
+  }
+}
+
 void AddressSpace::bindObject(const MemoryObject *mo, ObjectState *os) {
   assert(os->copyOnWriteOwner==0 && "object already has owner");
   os->copyOnWriteOwner = cowKey;
   objects = objects.replace(std::make_pair(mo, os));
+  updateIndex(mo, os);
 }
 
 void AddressSpace::unbindObject(const MemoryObject *mo) {
   objects = objects.remove(mo);
+
+  if (!getOwnIndex() || index->chunks.empty())
+    return;
+  std::size_t position = findChunk(*index, mo->address);
+  IndexChunk &chunk = getOwnChunk(position);
+  auto it = std::lower_bound(
+      chunk.begin(), chunk.end(), mo->address,
+      [](const IndexEntry &e, uint64_t a) { return e.address < a; });
+  if (it == chunk.end() || it->mo != mo)
+    return;
+  chunk.erase(it);
+  if (chunk.empty())
+    index->chunks.erase(index->chunks.begin() + position);
 }
 
 const ObjectState *AddressSpace::findObject(const MemoryObject *mo) const {
-  const auto res = objects.lookup(mo);
-  return res ? res->second.get() : nullptr;
+  const IndexEntry *entry = lookupPrevious(mo->address);
+  return entry && entry->mo == mo ? entry->os : nullptr;
 }
 
 ObjectState *AddressSpace::getWriteable(const MemoryObject *mo,
@@ -49,6 +151,7 @@ ObjectState *AddressSpace::getWriteable(const MemoryObject *mo,
   ref<ObjectState> newObjectState(new ObjectState(*os));
   newObjectState->copyOnWriteOwner = cowKey;
   objects = objects.replace(std::make_pair(mo, newObjectState));
+  updateIndex(mo, newObjectState.get());
   return newObjectState.get();
 }
 
@@ -56,17 +159,18 @@ ObjectState *AddressSpace::getWriteable(const MemoryObject *mo,
 
 bool AddressSpace::resolveOne(const ref<ConstantExpr> &addr, 
                               ObjectPair &result) const {
-  uint64_t address = addr->getZExtValue();
-  MemoryObject hack(address);
+  return resolveOne(addr->getZExtValue(), result);
+}
 
-  if (const auto res = objects.lookup_previous(&hack)) {
-    const auto &mo = res->first;
+bool AddressSpace::resolveOne(uint64_t address, ObjectPair &result) const {
+  if (const IndexEntry *entry = lookupPrevious(address)) {
+    const auto &mo = entry->mo;
     // Check if the provided address is between start and end of the object
     // [mo->address, mo->address + mo->size) or the object is a 0-sized object.
     if ((mo->size==0 && address==mo->address) ||
         (address - mo->address < mo->size)) {
-      result.first = res->first;
-      result.second = res->second.get();
+      result.first = entry->mo;
+      result.second = entry->os;
       return true;
     }
   }
@@ -91,28 +195,23 @@ bool AddressSpace::resolveOne(ExecutionState &state,
     if (!solver->getValue(state.constraints, address, cex, state.queryMetaData))
       return false;
     uint64_t example = cex->getZExtValue();
-    MemoryObject hack(example);
-    const auto res = objects.lookup_previous(&hack);
 
-    if (res) {
-      const MemoryObject *mo = res->first;
+    if (const IndexEntry *entry = lookupPrevious(example)) {
+      const MemoryObject *mo = entry->mo;
       if (example - mo->address < mo->size) {
-        result.first = res->first;
-        result.second = res->second.get();
+        result.first = entry->mo;
+        result.second = entry->os;
         success = true;
         return true;
       }
     }
 
     // didn't work, now we have to search
-       
-    MemoryMap::iterator oi = objects.upper_bound(&hack);
-    MemoryMap::iterator begin = objects.begin();
-    MemoryMap::iterator end = objects.end();
-      
-    MemoryMap::iterator start = oi;
-    while (oi!=begin) {
-      --oi;
+    MemoryMap::iterator oi = objects.begin(), end = objects.end();
+    if (!findCandidates(state, solver, address, oi, end, timer))
+      return false;
+
+    for (; oi != end; ++oi) {
       const auto &mo = oi->first;
 
       bool mayBeTrue;
@@ -125,41 +224,6 @@ bool AddressSpace::resolveOne(ExecutionState &state,
         result.second = oi->second.get();
         success = true;
         return true;
-      } else {
-        bool mustBeTrue;
-        if (!solver->mustBeTrue(state.constraints,
-                                UgeExpr::create(address, mo->getBaseExpr()),
-                                mustBeTrue, state.queryMetaData))
-          return false;
-        if (mustBeTrue)
-          break;
-      }
-    }
-
-    // search forwards
-    for (oi=start; oi!=end; ++oi) {
-      const auto &mo = oi->first;
-
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state.constraints,
-                              UltExpr::create(address, mo->getBaseExpr()),
-                              mustBeTrue, state.queryMetaData))
-        return false;
-      if (mustBeTrue) {
-        break;
-      } else {
-        bool mayBeTrue;
-
-        if (!solver->mayBeTrue(state.constraints,
-                               mo->getBoundsCheckPointer(address), mayBeTrue,
-                               state.queryMetaData))
-          return false;
-        if (mayBeTrue) {
-          result.first = oi->first;
-          result.second = oi->second.get();
-          success = true;
-          return true;
-        }
       }
     }
 
@@ -168,6 +232,39 @@ bool AddressSpace::resolveOne(ExecutionState &state,
   }
 }
 
+bool AddressSpace::findCandidates(ExecutionState &state, TimingSolver *solver,
+                                  ref<Expr> p, MemoryMap::iterator &first,
+                                  MemoryMap::iterator &last,
+                                  const TimerStatIncrementer &timer,
+                                  time::Span timeout) const {
+  // Objects do not overlap, so p cannot point into any object below the last
+  // one it is known to be at or above, nor into any object starting above
+  // all of its values. Both bounds are found by a binary search over the
+  // objects, with one query per level of the map.
+  bool failed = false;
+  auto mustBeTrue = [&](ref<Expr> condition) {
+    if (timeout && timeout < timer.delta())
+      failed = true;
+    bool result = false;
+    if (!failed && !solver->mustBeTrue(state.constraints, condition, result,
+                                       state.queryMetaData))
+      failed = true;
+    return result;
+  };
+
+  first = objects.partition_point([&](const MemoryMap::value_type &v) {
+    return mustBeTrue(UgeExpr::create(p, v.first->getBaseExpr()));
+  });
+  if (first != objects.begin())
+    --first;
+
+  last = objects.partition_point([&](const MemoryMap::value_type &v) {
+    return !mustBeTrue(UltExpr::create(p, v.first->getBaseExpr()));
+  });
+
+  return !failed;
+}
+
 int AddressSpace::checkPointerInObject(ExecutionState &state,
                                        TimingSolver *solver, ref<Expr> p,
                                        const ObjectPair &op, ResolutionList &rl,
@@ -215,71 +312,33 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
   } else {
     TimerStatIncrementer timer(stats::resolveTime);
 
-    // XXX in general this isn't exactly what we want... for
-    // a multiple resolution case (or for example, a \in {b,c,0})
-    // we want to find the first object, find a cex assuming
-    // not the first, find a cex assuming not the second...
-    // etc.
-
-    // XXX how do we smartly amortize the cost of checking to
-    // see if we need to keep searching up/down, in bad cases?
-    // maybe we don't care?
-
-    // XXX we really just need a smart place to start (although
-    // if its a known solution then the code below is guaranteed
-    // to hit the fast path with exactly 2 queries). we could also
-    // just get this by inspection of the expr.
-
+    // Most pointers can only point into the object containing an example
+    // value, which costs two queries to confirm.
     ref<ConstantExpr> cex;
     if (!solver->getValue(state.constraints, p, cex, state.queryMetaData))
       return true;
-    uint64_t example = cex->getZExtValue();
-    MemoryObject hack(example);
-
-    MemoryMap::iterator oi = objects.upper_bound(&hack);
-    MemoryMap::iterator begin = objects.begin();
-    MemoryMap::iterator end = objects.end();
-
-    MemoryMap::iterator start = oi;
-    // search backwards, start with one minus because this
-    // is the object that p *should* be within, which means we
-    // get write off the end with 4 queries
-    while (oi != begin) {
-      --oi;
-      const MemoryObject *mo = oi->first;
-      if (timeout && timeout < timer.delta())
-        return true;
-
-      auto op = std::make_pair<>(mo, oi->second.get());
-
-      int incomplete =
-          checkPointerInObject(state, solver, p, op, rl, maxResolutions);
-      if (incomplete != 2)
-        return incomplete ? true : false;
-
+    ObjectPair res;
+    if (resolveOne(cex, res)) {
       bool mustBeTrue;
       if (!solver->mustBeTrue(state.constraints,
-                              UgeExpr::create(p, mo->getBaseExpr()), mustBeTrue,
+                              res.first->getBoundsCheckPointer(p), mustBeTrue,
                               state.queryMetaData))
         return true;
-      if (mustBeTrue)
-        break;
+      if (mustBeTrue) {
+        rl.push_back(res);
+        return false;
+      }
     }
 
-    // search forwards
-    for (oi = start; oi != end; ++oi) {
-      const MemoryObject *mo = oi->first;
+    MemoryMap::iterator oi = objects.begin(), end = objects.end();
+    if (!findCandidates(state, solver, p, oi, end, timer, timeout))
+      return true;
+
+    for (; oi != end; ++oi) {
       if (timeout && timeout < timer.delta())
         return true;
 
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state.constraints,
-                              UltExpr::create(p, mo->getBaseExpr()), mustBeTrue,
-                              state.queryMetaData))
-        return true;
-      if (mustBeTrue)
-        break;
-      auto op = std::make_pair<>(mo, oi->second.get());
+      auto op = std::make_pair<>(oi->first, oi->second.get());
 
       int incomplete =
           checkPointerInObject(state, solver, p, op, rl, maxResolutions);
@@ -307,9 +366,64 @@ void AddressSpace::copyOutConcretes() {
       auto address = reinterpret_cast<std::uint8_t*>(mo->address);
 
       if (!os->readOnly)
-        memcpy(address, os->concreteStore, mo->size);
+        os->concreteStore.copyTo(address);
+    }
+  }
+}
+
+bool AddressSpace::collectReachable(std::vector<uint64_t> addresses,
+                                    ResolutionList &reachable) const {
+  const unsigned pointerBytes = Context::get().getPointerWidth() / 8;
+  const bool littleEndian = Context::get().isLittleEndian();
+
+  std::unordered_set<const MemoryObject *> visited;
+  while (!addresses.empty()) {
+    uint64_t address = addresses.back();
+    addresses.pop_back();
+
+    // a pointer just past an object, e.g. the end of an array, reaches it
+    ObjectPair op;
+    if (!resolveOne(address, op) && !(address && resolveOne(address - 1, op)))
+      continue;
+    if (!visited.insert(op.first).second)
+      continue;
+    if (!op.second->isConcrete())
+      return false;
+    reachable.push_back(op);
+
+    const auto &store = op.second->concreteStore;
+    unsigned offset =
+        (pointerBytes - op.first->address % pointerBytes) % pointerBytes;
+    for (; offset + pointerBytes <= op.second->size; offset += pointerBytes) {
+      uint64_t word = 0;
+      for (unsigned i = 0; i < pointerBytes; ++i) {
+        unsigned byte = littleEndian ? pointerBytes - 1 - i : i;
+        word = (word << 8) | store[offset + byte];
+      }
+      if (word)
+        addresses.push_back(word);
     }
   }
+
+  return true;
+}
+
+void AddressSpace::copyOutConcretes(const ResolutionList &objects) {
+  for (const auto &op : objects) {
+    if (!op.first->isUserSpecified && !op.second->readOnly)
+      op.second->concreteStore.copyTo(
+          reinterpret_cast<std::uint8_t *>(op.first->address));
+  }
+}
+
+bool AddressSpace::copyInConcretes(const ResolutionList &objects) {
+  for (const auto &op : objects) {
+    if (!op.first->isUserSpecified &&
+        !copyInConcrete(op.first, op.second, op.first->address))
+      return false;
+  }
+
+  return true;
 }
 
 bool AddressSpace::copyInConcretes() {
@@ -330,12 +444,12 @@ bool AddressSpace::copyInConcretes() {
 bool AddressSpace::copyInConcrete(const MemoryObject *mo, const ObjectState *os,
                                   uint64_t src_address) {
   auto address = reinterpret_cast<std::uint8_t*>(src_address);
-  if (memcmp(address, os->concreteStore, mo->size) != 0) {
+  if (!os->concreteStore.equals(address)) {
     if (os->readOnly) {
       return false;
     } else {
       ObjectState *wos = getWriteable(mo, os);
-      memcpy(wos->concreteStore, address, mo->size);
+      wos->concreteStore.assign(address);
     }
   }
   return true;
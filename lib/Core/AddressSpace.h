@@ -16,11 +16,15 @@
 #include "klee/ADT/ImmutableMap.h"
 #include "klee/System/Time.h"
 
+#include <memory>
+#include <vector>
+
 namespace klee {
   class ExecutionState;
   class MemoryObject;
   class ObjectState;
   class TimingSolver;
+  class TimerStatIncrementer;
 
   template<class T> class ref;
 
@@ -40,6 +44,47 @@ namespace klee {
     /// Epoch counter used to control ownership of objects.
     mutable unsigned cowKey;
 
+    struct IndexEntry {
+      uint64_t address;
+      const MemoryObject *mo;
+      const ObjectState *os;
+    };
+    typedef std::vector<IndexEntry> IndexChunk;
+
+    /// \ref objects as sorted array, so concrete addresses are resolved by
+    /// a binary search instead of a walk through the tree. The array is
+    /// split into chunks in address order, none of them empty.
+    struct Index {
+      std::vector<std::shared_ptr<IndexChunk>> chunks;
+    };
+
+    /// The index is built on demand and shared with copies of this address
+    /// space, like its chunks. A change to \ref objects copies the list of
+    /// chunks and the one chunk it touches if they are shared, so the first
+    /// change after a fork costs O(n / chunk size + chunk size).
+    mutable std::shared_ptr<Index> index;
+
+    const Index &getIndex() const;
+
+    /// \return the entry of the object with the greatest address not above
+    /// `address`, or null if there is none.
+    const IndexEntry *lookupPrevious(uint64_t address) const;
+
+    /// \return the position of the chunk that holds or would hold the entry
+    /// for `address`, 0 if it lies below all of them.
+    static std::size_t findChunk(const Index &index, uint64_t address);
+
+    /// \return the index, copied first if another address space refers to
+    /// it, or null if it was not built yet.
+    Index *getOwnIndex();
+
+    /// \return the chunk at `position` of the own index, copied first if
+    /// another index refers to it.
+    IndexChunk &getOwnChunk(std::size_t position);
+
+    /// Replaces or adds the entry of `mo` in the index.
+    void updateIndex(const MemoryObject *mo, const ObjectState *os);
+
     /// Unsupported, use copy constructor
     AddressSpace &operator=(const AddressSpace &);
 
@@ -54,6 +99,20 @@ namespace klee {
                              ref<Expr> p, const ObjectPair &op,
                              ResolutionList &rl, unsigned maxResolutions) const;
 
+    /// Narrow the objects pointer `p` can point into to the range
+    /// [`first`, `last`) of \ref objects with O(log n) solver queries.
+    /// The objects outside of the range lie entirely below or above all
+    /// values `p` can take.
+    ///
+    /// \param timer The timer of the resolution, checked against
+    /// `timeout` before each query.
+    /// \return false iff a query timed out or `timeout` expired.
+    bool findCandidates(ExecutionState &state, TimingSolver *solver,
+                        ref<Expr> p, MemoryMap::iterator &first,
+                        MemoryMap::iterator &last,
+                        const TimerStatIncrementer &timer,
+                        time::Span timeout = time::Span()) const;
+
   public:
     /// The MemoryObject -> ObjectState map that constitutes the
     /// address space.
@@ -65,13 +124,15 @@ namespace klee {
     MemoryMap objects;
 
     AddressSpace() : cowKey(1) {}
-    AddressSpace(const AddressSpace &b) : cowKey(++b.cowKey), objects(b.objects) { }
+    AddressSpace(const AddressSpace &b)
+        : cowKey(++b.cowKey), index(b.index), objects(b.objects) {}
     ~AddressSpace() {}
 
     /// Resolve address to an ObjectPair in result.
     /// \return true iff an object was found.
     bool resolveOne(const ref<ConstantExpr> &address, 
                     ObjectPair &result) const;
+    bool resolveOne(uint64_t address, ObjectPair &result) const;
 
     /// Resolve address to an ObjectPair in result.
     ///
@@ -124,10 +185,22 @@ namespace klee {
     /// \return A writeable ObjectState (\a os or a copy).
     ObjectState *getWriteable(const MemoryObject *mo, const ObjectState *os);
 
+    /// Collect the objects the given addresses point into or just past,
+    /// and transitively the objects the pointer-aligned words of their
+    /// contents point into.
+    ///
+    /// \return false iff one of the objects has a symbolic byte; the
+    /// collection stops there.
+    bool collectReachable(std::vector<uint64_t> addresses,
+                          ResolutionList &reachable) const;
+
     /// Copy the concrete values of all managed ObjectStates into the
     /// actual system memory location they were allocated at.
     void copyOutConcretes();
 
+    /// Like copyOutConcretes, for the given objects only.
+    void copyOutConcretes(const ResolutionList &objects);
+
     /// Copy the concrete values of all managed ObjectStates back from
     /// the actual system memory location they were allocated
     /// at. ObjectStates will only be written to (and thus,
@@ -138,6 +211,9 @@ namespace klee {
     /// \retval false The copy failed because a read-only object was modified.
     bool copyInConcretes();
 
+    /// Like copyInConcretes, for the given objects only.
+    bool copyInConcretes(const ResolutionList &objects);
+
     /// Updates the memory object with the raw memory from the address
     ///
     /// @param mo The MemoryObject to update
@@ -0,0 +1,97 @@
+//===-- Checkpoint.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace klee;
+
+namespace {
+const char *const CheckpointMagic = "klee-checkpoint";
+const unsigned CheckpointVersion = 1;
+} // namespace
+
+bool Checkpoint::write(const std::string &fileName) const {
+  std::string tmpFileName = fileName + ".tmp";
+  {
+    std::ofstream out(tmpFileName, std::ios::trunc);
+    if (!out)
+      return false;
+
+    out << CheckpointMagic << ' ' << CheckpointVersion << '\n';
+
+    out << "statistics " << statistics.size() << '\n';
+    for (const auto &statistic : statistics)
+      out << statistic.first << ' ' << statistic.second << '\n';
+
+    out << "states " << states.size() << '\n';
+    for (const auto &decisions : states) {
+      out << decisions.size();
+      for (std::uint32_t decision : decisions)
+        out << ' ' << decision;
+      out << '\n';
+    }
+
+    out.close();
+    if (!out) {
+      std::remove(tmpFileName.c_str());
+      return false;
+    }
+  }
+
+  return std::rename(tmpFileName.c_str(), fileName.c_str()) == 0;
+}
+
+bool Checkpoint::read(const std::string &fileName) {
+  std::ifstream in(fileName);
+  std::string word;
+  unsigned version;
+  if (!(in >> word >> version) || word != CheckpointMagic ||
+      version != CheckpointVersion)
+    return false;
+
+  std::size_t count;
+  if (!(in >> word >> count) || word != "statistics")
+    return false;
+  statistics.resize(count);
+  for (auto &statistic : statistics)
+    in >> statistic.first >> statistic.second;
+
+  if (!(in >> word >> count) || word != "states")
+    return false;
+  states.resize(count);
+  for (auto &decisions : states) {
+    if (!(in >> count))
+      return false;
+    decisions.resize(count);
+    for (auto &decision : decisions)
+      in >> decision;
+  }
+
+  return !in.fail();
+}
+
+CheckpointTree::CheckpointTree(const Checkpoint &checkpoint) : children(1) {
+  for (const auto &decisions : checkpoint.states) {
+    NodeID node = getRoot();
+    for (std::uint32_t decision : decisions) {
+      auto it = children[node].find(decision);
+      if (it == children[node].end()) {
+        NodeID child = children.size();
+        children[node].emplace(decision, child);
+        children.emplace_back();
+        node = child;
+      } else {
+        node = it->second;
+      }
+    }
+  }
+}
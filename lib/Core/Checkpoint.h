@@ -0,0 +1,69 @@
+//===-- Checkpoint.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_CHECKPOINT_H
+#define KLEE_CHECKPOINT_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace klee {
+
+/// The exploration frontier of a run together with its statistics. A state
+/// is stored as the decisions it took at its symbolic branches (see
+/// ExecutionState::decisions), resuming replays these decisions from the
+/// entry point. This rebuilds the states and their process tree without
+/// storing any expressions or memory contents.
+struct Checkpoint {
+  /// Values of the statistics, by name.
+  std::vector<std::pair<std::string, std::uint64_t>> statistics;
+
+  /// Decisions of every state alive when the checkpoint was taken.
+  std::vector<std::vector<std::uint32_t>> states;
+
+  /// Writes to a temporary file first and renames it afterwards, an
+  /// interrupted write never destroys the previous checkpoint.
+  bool write(const std::string &fileName) const;
+
+  bool read(const std::string &fileName);
+};
+
+/// Prefix tree of the decisions of the states of a checkpoint. A resumed
+/// state follows it at every symbolic branch. Branch targets without a node
+/// were finished before the checkpoint was taken, a leaf is the point a state
+/// was at when the checkpoint was taken.
+class CheckpointTree {
+public:
+  typedef unsigned NodeID;
+
+private:
+  std::vector<std::map<std::uint32_t, NodeID>> children;
+
+public:
+  explicit CheckpointTree(const Checkpoint &checkpoint);
+
+  NodeID getRoot() const { return 0; }
+
+  bool isLeaf(NodeID node) const { return children[node].empty(); }
+
+  bool hasChild(NodeID node, std::uint32_t decision) const {
+    return children[node].count(decision) != 0;
+  }
+
+  NodeID getChild(NodeID node, std::uint32_t decision) const {
+    return children[node].at(decision);
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_CHECKPOINT_H */
@@ -30,6 +30,22 @@ namespace stats {
   /// The number of process forks.
   extern Statistic forks;
 
+  /// The number of allocations served by the MemoryPool.
+  extern Statistic poolAllocations;
+
+  /// The number of slabs the MemoryPool reserved for its size classes.
+  extern Statistic poolSlabs;
+
+  /// The number of reads of object states that go through their update
+  /// list, and the sum of the depths of those lists. Their quotient is the
+  /// average update list depth.
+  extern Statistic updateListReads;
+  extern Statistic updateListDepth;
+
+  /// The number of states of speculative forks that turned out to be
+  /// infeasible.
+  extern Statistic infeasibleForks;
+
   /// Number of states, this is a "fake" statistic used by istats, it
   /// isn't normally up-to-date.
   extern Statistic states;
@@ -48,9 +48,8 @@ std::uint32_t ExecutionState::nextID = 1;
 
 StackFrame::StackFrame(KInstIterator _caller, KFunction *_kf)
   : caller(_caller), kf(_kf), callPathNode(0), 
-    minDistToUncoveredOnReturn(0), varargs(0) {
-  locals = new Cell[kf->numRegisters];
-}
+    minDistToUncoveredOnReturn(0), varargs(0),
+    locals(new Cell[kf->numRegisters], std::default_delete<Cell[]>()) {}
 
 StackFrame::StackFrame(const StackFrame &s) 
   : caller(s.caller),
@@ -58,14 +57,32 @@ StackFrame::StackFrame(const StackFrame &s)
     callPathNode(s.callPathNode),
     allocas(s.allocas),
     minDistToUncoveredOnReturn(s.minDistToUncoveredOnReturn),
-    varargs(s.varargs) {
-  locals = new Cell[s.kf->numRegisters];
-  for (unsigned i=0; i<s.kf->numRegisters; i++)
-    locals[i] = s.locals[i];
+    varargs(s.varargs),
+    locals(s.locals),
+    segments(s.segments) {}
+
+StackFrame::~StackFrame() {}
+
+void StackFrame::copyLocals() {
+  Cell *copy = new Cell[kf->numRegisters];
+  std::copy(locals.get(), locals.get() + kf->numRegisters, copy);
+  locals.reset(copy, std::default_delete<Cell[]>());
 }
 
-StackFrame::~StackFrame() { 
-  delete[] locals; 
+void StackFrame::setSegment(unsigned index, ref<ConstantExpr> segment) {
+  if (!segments) {
+    if (segment.isNull())
+      return;
+    segments.reset(new ref<ConstantExpr>[kf->numRegisters],
+                   std::default_delete<ref<ConstantExpr>[]>());
+  } else if (segments.get()[index] == segment) {
+    return;
+  } else if (segments.use_count() > 1) {
+    auto *copy = new ref<ConstantExpr>[kf->numRegisters];
+    std::copy(segments.get(), segments.get() + kf->numRegisters, copy);
+    segments.reset(copy, std::default_delete<ref<ConstantExpr>[]>());
+  }
+  segments.get()[index] = segment;
 }
 
 /***/
@@ -99,9 +116,11 @@ ExecutionState::ExecutionState(const ExecutionState& state):
     depth(state.depth),
     addressSpace(state.addressSpace),
     constraints(state.constraints),
+    unverifiedCondition(state.unverifiedCondition),
+    unverifiedTrueBranch(state.unverifiedTrueBranch),
     pathOS(state.pathOS),
     symPathOS(state.symPathOS),
-    coveredLines(state.coveredLines),
+    decisions(state.decisions),
     symbolics(state.symbolics),
     arrayNames(state.arrayNames),
     openMergeStack(state.openMergeStack),
@@ -122,7 +141,6 @@ ExecutionState *ExecutionState::branch() {
   auto *falseState = new ExecutionState(*this);
   falseState->setID();
   falseState->coveredNew = false;
-  falseState->coveredLines.clear();
 
   return falseState;
 }
@@ -282,8 +300,8 @@ bool ExecutionState::merge(const ExecutionState &b) {
     StackFrame &af = *itA;
     const StackFrame &bf = *itB;
     for (unsigned i=0; i<af.kf->numRegisters; i++) {
-      ref<Expr> &av = af.locals[i].value;
-      const ref<Expr> &bv = bf.locals[i].value;
+      ref<Expr> &av = af.getWritableLocal(i).value;
+      const ref<Expr> &bv = bf.getLocal(i).value;
       if (!av || !bv) {
         // if one is null then by implication (we are at same pc)
         // we cannot reuse this local, so just ignore
@@ -342,7 +360,7 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
 
       out << ai->getName().str();
       // XXX should go through function
-      ref<Expr> value = sf.locals[sf.kf->getArgRegister(index++)].value;
+      ref<Expr> value = sf.getLocal(sf.kf->getArgRegister(index++)).value;
       if (isa_and_nonnull<ConstantExpr>(value))
         out << "=" << value;
     }
@@ -13,9 +13,12 @@
 #include "AddressSpace.h"
 #include "MergeHandler.h"
 
+#include "klee/ADT/ImmutableList.h"
+#include "klee/ADT/ImmutableSet.h"
 #include "klee/ADT/TreeStream.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Module/Cell.h"
 #include "klee/Module/KInstIterator.h"
 #include "klee/Solver/Solver.h"
 #include "klee/System/Time.h"
@@ -28,7 +31,6 @@
 namespace klee {
 class Array;
 class CallPathNode;
-struct Cell;
 struct KFunction;
 struct KInstruction;
 class MemoryObject;
@@ -43,7 +45,6 @@ struct StackFrame {
   CallPathNode *callPathNode;
 
   std::vector<const MemoryObject *> allocas;
-  Cell *locals;
 
   /// Minimum distance to an uncovered instruction once the function
   /// returns. This is not a good place for this but is used to
@@ -62,6 +63,39 @@ struct StackFrame {
   StackFrame(KInstIterator caller, KFunction *kf);
   StackFrame(const StackFrame &s);
   ~StackFrame();
+
+  const Cell &getLocal(unsigned index) const { return locals.get()[index]; }
+
+  /// Returns a register for writing, the registers are copied first if they
+  /// are still shared with the frame of another state.
+  Cell &getWritableLocal(unsigned index) {
+    if (locals.use_count() > 1)
+      copyLocals();
+    return locals.get()[index];
+  }
+
+  /// The segment of a register for -segmented-pointers, or null if it
+  /// carries none.
+  ref<ConstantExpr> getSegment(unsigned index) const {
+    return segments ? segments.get()[index] : nullptr;
+  }
+
+  void setSegment(unsigned index, ref<ConstantExpr> segment);
+
+private:
+  friend class StateSerializer;
+
+  /// Registers of the frame, shared between a frame and its copies until one
+  /// of them writes to a register. This keeps forking independent of the
+  /// number and size of the frames on the stack.
+  std::shared_ptr<Cell> locals;
+
+  /// Segments of the registers, shared like \ref locals. They are only
+  /// allocated once a register gets a segment, so frames do not pay for
+  /// them without -segmented-pointers.
+  std::shared_ptr<ref<ConstantExpr>> segments;
+
+  void copyLocals();
 };
 
 /// Contains information related to unwinding (Itanium ABI/2-Phase unwinding)
@@ -182,6 +216,14 @@ public:
   /// @brief Constraints collected so far
   ConstraintSet constraints;
 
+  /// @brief Branch condition of a speculative fork that was not checked for
+  /// feasibility yet, null otherwise. It becomes a constraint once the state
+  /// is selected, or the state is dropped if it cannot hold.
+  ref<Expr> unverifiedCondition;
+
+  /// @brief Whether \ref unverifiedCondition leads to the true successor
+  bool unverifiedTrueBranch = false;
+
   /// Statistics and information
 
   /// @brief Metadata utilized and collected by solvers for this state
@@ -195,7 +237,13 @@ public:
   /// taken to reach/create this state
   TreeOStream symPathOS;
 
-  /// @brief Set containing which lines in which files are covered by this state
+  /// @brief Choices made at the symbolic branches of this state: the taken
+  /// direction of a fork or the taken target of a multi-way branch. Only
+  /// recorded when checkpoints are written.
+  ImmutableList<std::uint32_t> decisions;
+
+  /// @brief Set containing which lines in which files are covered by this state.
+  /// Not inherited by states forked from this state.
   std::map<const std::string *, std::set<std::uint32_t>> coveredLines;
 
   /// @brief Pointer to the process tree of the current state
@@ -203,12 +251,10 @@ public:
   PTreeNode *ptreeNode = nullptr;
 
   /// @brief Ordered list of symbolics: used to generate test cases.
-  //
-  // FIXME: Move to a shared list structure (not critical).
-  std::vector<std::pair<ref<const MemoryObject>, const Array *>> symbolics;
+  ImmutableList<std::pair<ref<const MemoryObject>, const Array *>> symbolics;
 
   /// @brief Set of used array names for this state.  Used to avoid collisions.
-  std::set<std::string> arrayNames;
+  ImmutableSet<std::string> arrayNames;
 
   /// @brief The objects handling the klee_open_merge calls this state ran through
   std::vector<ref<MergeHandler>> openMergeStack;
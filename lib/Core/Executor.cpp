@@ -21,6 +21,7 @@
 #include "Searcher.h"
 #include "SeedInfo.h"
 #include "SpecialFunctionHandler.h"
+#include "StateSerializer.h"
 #include "StatsTracker.h"
 #include "TimingSolver.h"
 #include "UserSearcher.h"
@@ -62,6 +63,7 @@
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
@@ -115,6 +117,11 @@ cl::OptionCategory
 cl::OptionCategory TestGenCat("Test generation options",
                               "These options impact test generation.");
 
+cl::OptionCategory
+    CheckpointCat("Checkpoint options",
+                  "These options control checkpoints of the exploration and "
+                  "resuming a run from its latest checkpoint.");
+
 cl::opt<std::string> MaxTime(
     "max-time",
     cl::desc("Halt execution after the specified duration.  "
@@ -125,6 +132,26 @@ cl::opt<std::string> MaxTime(
 
 namespace {
 
+/*** Checkpoint options ***/
+
+const char *const CheckpointFileName = "checkpoint";
+
+cl::opt<std::string> CheckpointInterval(
+    "checkpoint-interval",
+    cl::desc("Write a checkpoint of all states to the output directory at "
+             "this interval and when halting.  Set to 0s to disable "
+             "(default=0s)"),
+    cl::init("0s"),
+    cl::cat(CheckpointCat));
+
+cl::opt<std::string> ResumeFrom(
+    "resume",
+    cl::desc("Continue the run with the given output directory from its "
+             "latest checkpoint.  The program and its arguments have to be "
+             "the same as for that run (see -checkpoint-interval)"),
+    cl::value_desc("output directory"),
+    cl::cat(CheckpointCat));
+
 /*** Test generation options ***/
 
 cl::opt<bool> DumpStatesOnHalt(
@@ -169,6 +196,23 @@ cl::opt<bool>
                                   "querying the solver (default=true)"),
                          cl::cat(SolvingCat));
 
+cl::opt<bool> SegmentedPointers(
+    "segmented-pointers",
+    cl::init(false),
+    cl::desc("Keep track of the object a pointer was derived from through "
+             "getelementptr, casts and phis.  Dereferencing a symbolic pointer "
+             "that stays inside that object then needs no search of the "
+             "address space (default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<bool> SpeculativeFork(
+    "speculative-fork",
+    cl::init(false),
+    cl::desc("Fork at symbolic branches without checking that both sides are "
+             "feasible.  A state is checked once it is selected and dropped if "
+             "its branch cannot be taken (default=false)"),
+    cl::cat(SolvingCat));
+
 
 /*** External call policy options ***/
 
@@ -210,6 +254,16 @@ cl::opt<bool> AllExternalWarnings(
              "as opposed to once per function (default=false)"),
     cl::cat(ExtCallsCat));
 
+cl::opt<bool> NativeConcreteCalls(
+    "native-concrete-calls",
+    cl::init(false),
+    cl::desc("Execute calls to internal functions natively when all arguments "
+             "and the memory the call can reach are concrete and the function "
+             "reaches no special functions and no function pointers.  Code "
+             "executed this way is not covered and cannot be interrupted "
+             "(default=false)"),
+    cl::cat(ExtCallsCat));
+
 
 /*** Seeding options ***/
 
@@ -331,6 +385,14 @@ cl::opt<bool> MaxMemoryInhibit(
     cl::init(true),
     cl::cat(TerminationCat));
 
+cl::opt<bool> SpillStates(
+    "spill-states",
+    cl::desc("Write states to disk instead of terminating them when above "
+             "memory cap (see -max-memory) and resume them once memory is "
+             "available again (default=false)"),
+    cl::init(false),
+    cl::cat(TerminationCat));
+
 cl::opt<unsigned> RuntimeMaxStackFrames(
     "max-stack-frames",
     cl::desc("Terminate a state after this many stack frames.  Set to 0 to "
@@ -462,7 +524,7 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
     : Interpreter(opts), interpreterHandler(ih), searcher(0),
       externalDispatcher(new ExternalDispatcher(ctx)), statsTracker(0),
       pathWriter(0), symPathWriter(0), specialFunctionHandler(0), timers{time::Span(TimerInterval)},
-      replayKTest(0), replayPath(0), usingSeeds(0),
+      recordDecisions(false), replayKTest(0), replayPath(0), usingSeeds(0),
       atMemoryLimit(false), inhibitForking(false), haltExecution(false),
       ivcEnabled(false), debugLogBuffer(debugBufferString) {
 
@@ -474,6 +536,38 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
         setHaltExecution(true);
       }));
 
+  const time::Span checkpointInterval{CheckpointInterval};
+  if (checkpointInterval) {
+    recordDecisions = true;
+    timers.add(std::make_unique<Timer>(checkpointInterval,
+                                       [&] { writeCheckpoint(); }));
+  }
+
+  if (!ResumeFrom.empty()) {
+    const std::string fileName = ResumeFrom + "/" + CheckpointFileName;
+    Checkpoint checkpoint;
+    if (!checkpoint.read(fileName))
+      klee_error("unable to read checkpoint %s", fileName.c_str());
+    if (checkpoint.states.empty())
+      klee_error("checkpoint %s has no states left to resume",
+                 fileName.c_str());
+    resumeTree = std::make_unique<CheckpointTree>(checkpoint);
+
+    // continue counting from the checkpoint, except for the statistics that
+    // are recomputed from the resumed states
+    for (const auto &statistic : checkpoint.statistics) {
+      Statistic *s = theStatisticManager->getStatisticByName(statistic.first);
+      if (!s || s == &stats::states || s == &stats::coveredInstructions ||
+          s == &stats::uncoveredInstructions ||
+          s == &stats::minDistToUncovered || s == &stats::minDistToReturn ||
+          s == &stats::reachableUncovered)
+        continue;
+      theStatisticManager->incrementStatistic(*s, statistic.second);
+    }
+    klee_message("resuming %lu states from %s", checkpoint.states.size(),
+                 fileName.c_str());
+  }
+
   coreSolverTimeout = time::Span{MaxCoreSolverTime};
   if (coreSolverTimeout) UseForkedCoreSolver = true;
   Solver *coreSolver = klee::createCoreSolver(CoreSolverToUse);
@@ -491,6 +585,10 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
   this->solver = new TimingSolver(solver, EqualitySubstitution);
   memory = new MemoryManager(&arrayCache);
 
+  if (SpillStates)
+    stateSerializer = std::make_unique<StateSerializer>(
+        interpreterHandler->getOutputFilename("spilled-states"));
+
   initializeSearchOptions();
 
   if (OnlyOutputStatesCoveringNew && !StatsTracker::useIStats())
@@ -897,7 +995,31 @@ void Executor::branch(ExecutionState &state,
   unsigned N = conditions.size();
   assert(N);
 
-  if (!branchingPermitted(state)) {
+  auto resumeIt = resumingStates.find(&state);
+  bool isResuming = false;
+  for (unsigned i=0; resumeIt != resumingStates.end() && i<N; ++i)
+    isResuming |= resumeTree->hasChild(resumeIt->second, i);
+
+  if (isResuming) {
+    // only create the targets the checkpointed run still had states for
+    const CheckpointTree::NodeID node = resumeIt->second;
+    bool isFirst = true;
+    for (unsigned i=0; i<N; ++i) {
+      if (!resumeTree->hasChild(node, i)) {
+        result.push_back(nullptr);
+      } else if (isFirst) {
+        result.push_back(&state);
+        isFirst = false;
+      } else {
+        ++stats::forks;
+        ExecutionState *ns = state.branch();
+        addedStates.push_back(ns);
+        resumingStates[ns] = node;
+        result.push_back(ns);
+        processTree->attach(state.ptreeNode, ns, &state);
+      }
+    }
+  } else if (!branchingPermitted(state)) {
     unsigned next = theRNG.getInt32() % N;
     for (unsigned i=0; i<N; ++i) {
       if (i == next) {
@@ -920,6 +1042,11 @@ void Executor::branch(ExecutionState &state,
     }
   }
 
+  for (unsigned i=0; i<N; ++i) {
+    if (result[i])
+      recordDecision(*result[i], i);
+  }
+
   // If necessary redistribute seeds to match conditions, killing
   // states if necessary due to OnlyReplaySeeds (inefficient but
   // simple).
@@ -1051,6 +1178,10 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     return StatePair(0, 0);
   }
 
+  // both directions are feasible, whichever is taken is a decision
+  const bool isDecision = res == Solver::Unknown;
+  auto resumeIt = resumingStates.find(&current);
+
   if (!isSeeding) {
     if (replayPath && !isInternal) {
       assert(replayPosition<replayPath->size() &&
@@ -1071,6 +1202,15 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
           addConstraint(current, Expr::createIsZero(condition));
         }
       }
+    } else if (res==Solver::Unknown && resumeIt != resumingStates.end()) {
+      // follow the checkpointed run, fork only if it had states on both sides
+      if (!resumeTree->hasChild(resumeIt->second, 1)) {
+        res = Solver::False;
+        addConstraint(current, Expr::createIsZero(condition));
+      } else if (!resumeTree->hasChild(resumeIt->second, 0)) {
+        res = Solver::True;
+        addConstraint(current, condition);
+      }
     } else if (res==Solver::Unknown) {
       assert(!replayKTest && "in replay mode, only one branch can be true.");
       
@@ -1132,6 +1272,8 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
         current.pathOS << "1";
       }
     }
+    if (isDecision)
+      recordDecision(current, 1);
 
     return StatePair(&current, 0);
   } else if (res==Solver::False) {
@@ -1140,6 +1282,8 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
         current.pathOS << "0";
       }
     }
+    if (isDecision)
+      recordDecision(current, 0);
 
     return StatePair(0, &current);
   } else {
@@ -1151,6 +1295,9 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     falseState = trueState->branch();
     addedStates.push_back(falseState);
 
+    if (resumeIt != resumingStates.end())
+      resumingStates[falseState] = resumeIt->second;
+
     if (it != seedMap.end()) {
       std::vector<SeedInfo> seeds = it->second;
       it->second.clear();
@@ -1208,6 +1355,9 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     addConstraint(*trueState, condition);
     addConstraint(*falseState, Expr::createIsZero(condition));
 
+    recordDecision(*trueState, 1);
+    recordDecision(*falseState, 0);
+
     // Kinda gross, do we even really still want this option?
     if (MaxDepth && MaxDepth<=trueState->depth) {
       terminateStateEarly(*trueState, "max-depth exceeded.");
@@ -1219,6 +1369,79 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
   }
 }
 
+bool Executor::canForkSpeculatively(const ExecutionState &current,
+                                    ref<Expr> condition) const {
+  // Seeds, replays and checkpoints depend on the outcome of the solver query
+  // at the branch, the other limits on not forking at all.
+  return SpeculativeFork && !isa<ConstantExpr>(condition) && !replayPath &&
+         !replayKTest && !recordDecisions && !symPathWriter &&
+         !seedMap.count(const_cast<ExecutionState *>(&current)) &&
+         !resumingStates.count(const_cast<ExecutionState *>(&current)) &&
+         MaxStaticForkPct == 1. && MaxStaticSolvePct == 1. &&
+         MaxStaticCPForkPct == 1. && MaxStaticCPSolvePct == 1. &&
+         !(MaxDepth && MaxDepth <= current.depth + 1) &&
+         branchingPermitted(current);
+}
+
+Executor::StatePair
+Executor::forkSpeculatively(ExecutionState &current, ref<Expr> condition) {
+  TimerStatIncrementer timer(stats::forkTime);
+  ExecutionState *falseState, *trueState = &current;
+
+  ++stats::forks;
+
+  falseState = trueState->branch();
+  addedStates.push_back(falseState);
+
+  processTree->attach(current.ptreeNode, falseState, trueState);
+
+  if (pathWriter) {
+    falseState->pathOS = pathWriter->open(current.pathOS);
+    trueState->pathOS << "1";
+    falseState->pathOS << "0";
+  }
+
+  trueState->unverifiedCondition = condition;
+  trueState->unverifiedTrueBranch = true;
+  falseState->unverifiedCondition = Expr::createIsZero(condition);
+  falseState->unverifiedTrueBranch = false;
+
+  return StatePair(trueState, falseState);
+}
+
+bool Executor::verifyCondition(ExecutionState &state) {
+  ref<Expr> condition = state.unverifiedCondition;
+  state.unverifiedCondition = nullptr;
+
+  bool feasible;
+  solver->setTimeout(coreSolverTimeout);
+  bool success = solver->mayBeTrue(state.constraints, condition, feasible,
+                                   state.queryMetaData);
+  solver->setTimeout(time::Span());
+  if (!success) {
+    terminateStateEarly(state, "Query timed out (speculative fork).");
+    return false;
+  }
+
+  if (!feasible) {
+    ++stats::infeasibleForks;
+    discardState(state);
+    return false;
+  }
+
+  addConstraint(state, condition);
+
+  // the state still stands right behind its branch instruction
+  if (statsTracker && state.stack.back().kf->trackCoverage) {
+    theStatisticManager->setIndex(state.prevPC->info->id);
+    if (state.unverifiedTrueBranch)
+      statsTracker->markBranchVisited(&state, nullptr);
+    else
+      statsTracker->markBranchVisited(nullptr, &state);
+  }
+  return true;
+}
+
 void Executor::addConstraint(ExecutionState &state, ref<Expr> condition) {
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(condition)) {
     if (!CE->isTrue())
@@ -1269,13 +1492,32 @@ const Cell& Executor::eval(KInstruction *ki, unsigned index,
   } else {
     unsigned index = vnumber;
     StackFrame &sf = state.stack.back();
-    return sf.locals[index];
+    return sf.getLocal(index);
   }
 }
 
 void Executor::bindLocal(KInstruction *target, ExecutionState &state, 
-                         ref<Expr> value) {
+                         ref<Expr> value, ref<ConstantExpr> segment) {
   getDestCell(state, target).value = value;
+  state.stack.back().setSegment(target->dest, segment);
+}
+
+ref<klee::ConstantExpr> Executor::evalSegment(KInstruction *ki, unsigned index,
+                                              ExecutionState &state) const {
+  int vnumber = ki->operands[index];
+  if (vnumber < 0)
+    return nullptr;
+  return state.stack.back().getSegment(vnumber);
+}
+
+ref<klee::ConstantExpr> Executor::getSegment(KInstruction *ki, unsigned index,
+                                             ExecutionState &state) const {
+  if (!SegmentedPointers)
+    return nullptr;
+  ref<ConstantExpr> segment = evalSegment(ki, index, state);
+  if (!segment.isNull())
+    return segment;
+  return dyn_cast<ConstantExpr>(eval(ki, index, state).value);
 }
 
 void Executor::bindArgument(KFunction *kf, unsigned index, 
@@ -1817,6 +2059,9 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
       transferToBasicBlock(ii->getNormalDest(), i->getParent(), state);
     }
   } else {
+    if (NativeConcreteCalls && tryNativeCall(state, ki, f, arguments))
+      return;
+
     // Check if maximum stack size was reached.
     // We currently only count the number of stack frames
     if (RuntimeMaxStackFrames && state.stack.size() > RuntimeMaxStackFrames) {
@@ -2000,7 +2245,7 @@ void Executor::transferToBasicBlock(BasicBlock *dst, BasicBlock *src,
   KFunction *kf = state.stack.back().kf;
   unsigned entry = kf->basicBlockEntry[dst];
   state.pc = &kf->instructions[entry];
-  if (state.pc->inst->getOpcode() == Instruction::PHI) {
+  if (state.pc->opcode == Instruction::PHI) {
     PHINode *first = static_cast<PHINode*>(state.pc->inst);
     state.incomingBBIndex = first->getBasicBlockIndex(src);
   }
@@ -2038,7 +2283,7 @@ Function* Executor::getTargetFunction(Value *calledVal, ExecutionState &state) {
 
 void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   Instruction *i = ki->inst;
-  switch (i->getOpcode()) {
+  switch (ki->opcode) {
     // Control flow
   case Instruction::Ret: {
     ReturnInst *ri = cast<ReturnInst>(i);
@@ -2156,13 +2401,17 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       ref<Expr> cond = eval(ki, 0, state).value;
 
       cond = optimizer.optimizeExpr(cond, false);
-      Executor::StatePair branches = fork(state, cond, false);
+      const bool speculative = canForkSpeculatively(state, cond);
+      Executor::StatePair branches = speculative
+                                         ? forkSpeculatively(state, cond)
+                                         : fork(state, cond, false);
 
       // NOTE: There is a hidden dependency here, markBranchVisited
       // requires that we still be in the context of the branch
       // instruction (it reuses its statistic id). Should be cleaned
       // up with convenient instruction specific data.
-      if (statsTracker && state.stack.back().kf->trackCoverage)
+      // Speculative branches are marked once they are known to be feasible.
+      if (statsTracker && state.stack.back().kf->trackCoverage && !speculative)
         statsTracker->markBranchVisited(branches.first, branches.second);
 
       if (branches.first)
@@ -2492,8 +2741,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     break;
   }
   case Instruction::PHI: {
-    ref<Expr> result = eval(ki, state.incomingBBIndex, state).value;
-    bindLocal(ki, state, result);
+    bindLocal(ki, state, eval(ki, state.incomingBBIndex, state).value,
+              evalSegment(ki, state.incomingBBIndex, state));
     break;
   }
 
@@ -2725,19 +2974,22 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::Load: {
     ref<Expr> base = eval(ki, 0, state).value;
-    executeMemoryOperation(state, false, base, 0, ki);
+    executeMemoryOperation(state, false, base, 0, ki,
+                           evalSegment(ki, 0, state));
     break;
   }
   case Instruction::Store: {
     ref<Expr> base = eval(ki, 1, state).value;
     ref<Expr> value = eval(ki, 0, state).value;
-    executeMemoryOperation(state, true, base, value, 0);
+    executeMemoryOperation(state, true, base, value, 0,
+                           evalSegment(ki, 1, state));
     break;
   }
 
   case Instruction::GetElementPtr: {
     KGEPInstruction *kgepi = static_cast<KGEPInstruction*>(ki);
     ref<Expr> base = eval(ki, 0, state).value;
+    ref<ConstantExpr> segment = getSegment(ki, 0, state);
 
     for (std::vector< std::pair<unsigned, uint64_t> >::iterator 
            it = kgepi->indices.begin(), ie = kgepi->indices.end(); 
@@ -2751,52 +3003,46 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     if (kgepi->offset)
       base = AddExpr::create(base,
                              Expr::createPointer(kgepi->offset));
-    bindLocal(ki, state, base);
+    bindLocal(ki, state, base, segment);
     break;
   }
 
     // Conversion
   case Instruction::Trunc: {
-    CastInst *ci = cast<CastInst>(i);
     ref<Expr> result = ExtractExpr::create(eval(ki, 0, state).value,
                                            0,
-                                           getWidthForLLVMType(ci->getType()));
+                                           ki->width);
     bindLocal(ki, state, result);
     break;
   }
   case Instruction::ZExt: {
-    CastInst *ci = cast<CastInst>(i);
     ref<Expr> result = ZExtExpr::create(eval(ki, 0, state).value,
-                                        getWidthForLLVMType(ci->getType()));
+                                        ki->width);
     bindLocal(ki, state, result);
     break;
   }
   case Instruction::SExt: {
-    CastInst *ci = cast<CastInst>(i);
     ref<Expr> result = SExtExpr::create(eval(ki, 0, state).value,
-                                        getWidthForLLVMType(ci->getType()));
+                                        ki->width);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::IntToPtr: {
-    CastInst *ci = cast<CastInst>(i);
-    Expr::Width pType = getWidthForLLVMType(ci->getType());
+    Expr::Width pType = ki->width;
     ref<Expr> arg = eval(ki, 0, state).value;
     bindLocal(ki, state, ZExtExpr::create(arg, pType));
     break;
   }
   case Instruction::PtrToInt: {
-    CastInst *ci = cast<CastInst>(i);
-    Expr::Width iType = getWidthForLLVMType(ci->getType());
+    Expr::Width iType = ki->width;
     ref<Expr> arg = eval(ki, 0, state).value;
     bindLocal(ki, state, ZExtExpr::create(arg, iType));
     break;
   }
 
   case Instruction::BitCast: {
-    ref<Expr> result = eval(ki, 0, state).value;
-    bindLocal(ki, state, result);
+    bindLocal(ki, state, eval(ki, 0, state).value, evalSegment(ki, 0, state));
     break;
   }
 
@@ -2891,8 +3137,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPTrunc: {
-    FPTruncInst *fi = cast<FPTruncInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
+    Expr::Width resultType = ki->width;
     ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
                                        "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > arg->getWidth())
@@ -2908,8 +3153,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPExt: {
-    FPExtInst *fi = cast<FPExtInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
+    Expr::Width resultType = ki->width;
     ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
                                         "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || arg->getWidth() > resultType)
@@ -2924,8 +3168,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPToUI: {
-    FPToUIInst *fi = cast<FPToUIInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
+    Expr::Width resultType = ki->width;
     ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
                                        "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > 64)
@@ -2946,8 +3189,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPToSI: {
-    FPToSIInst *fi = cast<FPToSIInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
+    Expr::Width resultType = ki->width;
     ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
                                        "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > 64)
@@ -2968,8 +3210,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::UIToFP: {
-    UIToFPInst *fi = cast<UIToFPInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
+    Expr::Width resultType = ki->width;
     ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
                                        "floating point");
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
@@ -2984,8 +3225,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::SIToFP: {
-    SIToFPInst *fi = cast<SIToFPInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
+    Expr::Width resultType = ki->width;
     ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
                                        "floating point");
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
@@ -3114,7 +3354,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
     ref<Expr> agg = eval(ki, 0, state).value;
 
-    ref<Expr> result = ExtractExpr::create(agg, kgepi->offset*8, getWidthForLLVMType(i->getType()));
+    ref<Expr> result = ExtractExpr::create(agg, kgepi->offset*8, ki->width);
 
     bindLocal(ki, state, result);
     break;
@@ -3295,6 +3535,14 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 }
 
 void Executor::updateStates(ExecutionState *current) {
+  // Most instructions neither fork nor terminate a state. The searcher is
+  // only told about those if it keeps track of the current state.
+  if (addedStates.empty() && removedStates.empty()) {
+    if (searcher && current && searcher->updatesCurrent())
+      searcher->update(current, addedStates, removedStates);
+    return;
+  }
+
   if (searcher) {
     searcher->update(current, addedStates, removedStates);
   }
@@ -3302,17 +3550,15 @@ void Executor::updateStates(ExecutionState *current) {
   states.insert(addedStates.begin(), addedStates.end());
   addedStates.clear();
 
-  for (std::vector<ExecutionState *>::iterator it = removedStates.begin(),
-                                               ie = removedStates.end();
-       it != ie; ++it) {
-    ExecutionState *es = *it;
-    std::set<ExecutionState*>::iterator it2 = states.find(es);
-    assert(it2!=states.end());
-    states.erase(it2);
+  for (ExecutionState *es : removedStates) {
+    bool erased = states.erase(es);
+    assert(erased);
+    (void) erased;
     std::map<ExecutionState*, std::vector<SeedInfo> >::iterator it3 = 
       seedMap.find(es);
     if (it3 != seedMap.end())
       seedMap.erase(it3);
+    resumingStates.erase(es);
     processTree->remove(es->ptreeNode);
     delete es;
   }
@@ -3412,20 +3658,34 @@ bool Executor::checkMemoryUsage() {
   const auto mmapUsage = memory->getUsedDeterministicSize() >> 20U;
   const auto totalUsage = mallocUsage + mmapUsage;
   atMemoryLimit = totalUsage > MaxMemory; // inhibit forking
-  if (!atMemoryLimit)
+  if (!atMemoryLimit) {
+    // resume spilled states while there is room for them
+    const auto resumeLimit = MaxMemory * 3UL / 4;
+    if (!spilledStates.empty() && totalUsage < resumeLimit) {
+      const auto numLive = states.size() - spilledStates.size();
+      resumeSpilledStates(std::max(
+          1UL, numLive * resumeLimit / std::max(1UL, totalUsage) - numLive));
+    }
     return true;
+  }
 
   // only terminate states when threshold (+100MB) exceeded
   if (totalUsage <= MaxMemory + 100)
     return true;
 
   // just guess at how many to kill
-  const auto numStates = states.size();
+  const auto numStates = states.size() - spilledStates.size();
   auto toKill = std::max(1UL, numStates - numStates * MaxMemory / totalUsage);
-  klee_warning("killing %lu states (over memory cap: %luMB)", toKill, totalUsage);
+  klee_warning("%s %lu states (over memory cap: %luMB)",
+               stateSerializer ? "spilling" : "killing", toKill, totalUsage);
 
   // randomly select states for early termination
-  std::vector<ExecutionState *> arr(states.begin(), states.end()); // FIXME: expensive
+  std::vector<ExecutionState *> arr; // FIXME: expensive
+  arr.reserve(numStates);
+  for (ExecutionState *es : states) {
+    if (!stateSerializer || !stateSerializer->isSpilled(*es))
+      arr.push_back(es);
+  }
   for (unsigned i = 0, N = arr.size(); N && i < toKill; ++i, --N) {
     unsigned idx = theRNG.getInt32() % N;
     // Make two pulls to try and not hit a state that
@@ -3434,22 +3694,112 @@ bool Executor::checkMemoryUsage() {
       idx = theRNG.getInt32() % N;
 
     std::swap(arr[idx], arr[N - 1]);
-    terminateStateEarly(*arr[N - 1], "Memory limit exceeded.");
+    if (!stateSerializer || !spillState(*arr[N - 1])) {
+      // a state from a speculative fork might not even exist
+      if (!arr[N - 1]->unverifiedCondition || verifyCondition(*arr[N - 1]))
+        terminateStateEarly(*arr[N - 1], "Memory limit exceeded.");
+    }
   }
 
   return false;
 }
 
+bool Executor::spillState(ExecutionState &state) {
+  // merging and seeding keep references to the state outside the searcher
+  if (!searcher || !state.openMergeStack.empty() || seedMap.count(&state))
+    return false;
+
+  if (!stateSerializer->spill(state))
+    return false;
+
+  searcher->update(nullptr, {}, {&state});
+  spilledStates.push_back(&state);
+  return true;
+}
+
+void Executor::resumeSpilledStates(std::size_t count) {
+  std::vector<ExecutionState *> resumed;
+  while (!spilledStates.empty() && resumed.size() < count) {
+    ExecutionState *es = spilledStates.front();
+    spilledStates.pop_front();
+    stateSerializer->restore(*es);
+    resumed.push_back(es);
+  }
+
+  if (searcher)
+    searcher->update(nullptr, resumed, {});
+}
+
+void Executor::recordDecision(ExecutionState &state, std::uint32_t decision) {
+  if (recordDecisions)
+    state.decisions.push_back(decision);
+
+  auto it = resumingStates.find(&state);
+  if (it == resumingStates.end())
+    return;
+
+  if (!resumeTree->hasChild(it->second, decision)) {
+    klee_warning_once(0, "resumed state diverged from the checkpointed run");
+    resumingStates.erase(it);
+    return;
+  }
+
+  it->second = resumeTree->getChild(it->second, decision);
+  // the state is where it was when the checkpoint was taken
+  if (resumeTree->isLeaf(it->second))
+    resumingStates.erase(it);
+}
+
+void Executor::writeCheckpoint() {
+  // the decisions of states still resuming are incomplete
+  if (!resumingStates.empty())
+    return;
+
+  Checkpoint checkpoint;
+  for (unsigned i = 0; i < theStatisticManager->getNumStatistics(); ++i) {
+    Statistic &s = theStatisticManager->getStatistic(i);
+    checkpoint.statistics.emplace_back(s.getName(), s.getValue());
+  }
+
+  // may be called in the middle of an instruction step
+  for (const ExecutionState *es : states) {
+    if (std::find(removedStates.begin(), removedStates.end(), es) ==
+        removedStates.end())
+      checkpoint.states.emplace_back(es->decisions.begin(),
+                                     es->decisions.end());
+  }
+  for (const ExecutionState *es : addedStates)
+    checkpoint.states.emplace_back(es->decisions.begin(), es->decisions.end());
+
+  const std::string fileName =
+      interpreterHandler->getOutputFilename(CheckpointFileName);
+  if (!checkpoint.write(fileName))
+    klee_warning("unable to write checkpoint %s", fileName.c_str());
+}
+
 void Executor::doDumpStates() {
+  if (recordDecisions)
+    writeCheckpoint();
+
   if (!DumpStatesOnHalt || states.empty()) {
     interpreterHandler->incPathsExplored(states.size());
     return;
   }
 
   klee_message("halting execution, dumping remaining states");
-  for (const auto &state : states)
-    terminateStateEarly(*state, "Execution halting.");
-  updateStates(nullptr);
+  // dump in creation order, independent of how the states were scheduled.
+  // every state is released right after it is dumped, so a spilled state is
+  // only read back in when it is its turn.
+  std::vector<ExecutionState *> remaining(states.begin(), states.end());
+  std::sort(remaining.begin(), remaining.end(), ExecutionStateIDCompare());
+  spilledStates.clear();
+  for (ExecutionState *state : remaining) {
+    if (stateSerializer && stateSerializer->isSpilled(*state))
+      stateSerializer->restore(*state);
+    if (!state->unverifiedCondition || verifyCondition(*state))
+      terminateStateEarly(*state, "Execution halting.");
+    updateStates(nullptr);
+  }
 }
 
 void Executor::run(ExecutionState &initialState) {
@@ -3460,6 +3810,36 @@ void Executor::run(ExecutionState &initialState) {
 
   states.insert(&initialState);
 
+  if (resumeTree) {
+    if (usingSeeds)
+      klee_error("seeds cannot be used when resuming a run");
+
+    // replay the decisions of the checkpointed states, the states the
+    // checkpointed run had already finished are never created
+    if (!resumeTree->isLeaf(resumeTree->getRoot()))
+      resumingStates[&initialState] = resumeTree->getRoot();
+
+    while (!resumingStates.empty()) {
+      if (haltExecution) {
+        doDumpStates();
+        return;
+      }
+
+      ExecutionState &state = *resumingStates.begin()->first;
+      KInstruction *ki = state.pc;
+      stepInstruction(state);
+
+      executeInstruction(state, ki);
+      timers.invoke();
+      if (::dumpStates) dumpStates();
+      if (::dumpPTree) dumpPTree();
+      updateStates(&state);
+    }
+
+    klee_message("resumed %lu states", states.size());
+    resumeTree.reset();
+  }
+
   if (usingSeeds) {
     std::vector<SeedInfo> &v = seedMap[&initialState];
     
@@ -3526,11 +3906,21 @@ void Executor::run(ExecutionState &initialState) {
   searcher = constructUserSearcher(*this);
 
   std::vector<ExecutionState *> newStates(states.begin(), states.end());
+  std::sort(newStates.begin(), newStates.end(), ExecutionStateIDCompare());
   searcher->update(0, newStates, std::vector<ExecutionState *>());
 
   // main interpreter loop
   while (!states.empty() && !haltExecution) {
+    // only spilled states are left
+    if (searcher->empty())
+      resumeSpilledStates(1);
+
     ExecutionState &state = searcher->selectState();
+    if (state.unverifiedCondition && !verifyCondition(state)) {
+      updateStates(nullptr);
+      continue;
+    }
+
     KInstruction *ki = state.pc;
     stepInstruction(state);
 
@@ -3613,7 +4003,10 @@ void Executor::terminateState(ExecutionState &state) {
   }
 
   interpreterHandler->incPathsExplored();
+  discardState(state);
+}
 
+void Executor::discardState(ExecutionState &state) {
   std::vector<ExecutionState *>::iterator it =
       std::find(addedStates.begin(), addedStates.end(), &state);
   if (it==addedStates.end()) {
@@ -3626,6 +4019,7 @@ void Executor::terminateState(ExecutionState &state) {
       seedMap.find(&state);
     if (it3 != seedMap.end())
       seedMap.erase(it3);
+    resumingStates.erase(&state);
     addedStates.erase(it);
     processTree->remove(state.ptreeNode);
     delete &state;
@@ -3888,6 +4282,189 @@ void Executor::callExternalFunction(ExecutionState &state,
   }
 }
 
+bool Executor::canRunNatively(Function *f) {
+  auto cached = nativeFunctions.find(f);
+  if (cached != nativeFunctions.end())
+    return cached->second.eligible;
+
+  // Function addresses inside the executor are not the addresses of any
+  // native code, so functions may only ever be called directly. The
+  // globals are collected, their objects are passed to the native code.
+  std::set<const GlobalVariable *> globals;
+  auto usesFunctionAddress = [&globals](const Constant *c) {
+    std::vector<const Constant *> constants{c};
+    while (!constants.empty()) {
+      const Constant *next = constants.back();
+      constants.pop_back();
+      if (isa<Function>(next) || isa<BlockAddress>(next))
+        return true;
+      if (const auto *gv = dyn_cast<GlobalVariable>(next)) {
+        globals.insert(gv);
+        continue;
+      }
+      if (const auto *ga = dyn_cast<GlobalAlias>(next)) {
+        constants.push_back(ga->getAliasee());
+        continue;
+      }
+      if (isa<GlobalValue>(next))
+        continue;
+      for (const Use &op : next->operands())
+        constants.push_back(cast<Constant>(op.get()));
+    }
+    return false;
+  };
+
+  bool eligible = true;
+  std::set<const Function *> visited{f};
+  std::vector<const Function *> worklist{f};
+  while (eligible && !worklist.empty()) {
+    const Function *g = worklist.back();
+    worklist.pop_back();
+
+    if (g->isVarArg() || g->hasPersonalityFn()) {
+      eligible = false;
+      break;
+    }
+
+    for (auto it = inst_begin(g), ie = inst_end(g); eligible && it != ie;
+         ++it) {
+      const Instruction &i = *it;
+      if (isa<InvokeInst>(i) || isa<LandingPadInst>(i) ||
+          isa<ResumeInst>(i)) {
+        eligible = false;
+        break;
+      }
+
+      const Value *callee = nullptr;
+      if (const auto *ci = dyn_cast<CallInst>(&i)) {
+#if LLVM_VERSION_CODE >= LLVM_VERSION(8, 0)
+        callee = ci->getCalledOperand();
+#else
+        callee = ci->getCalledValue();
+#endif
+        if (ci->isInlineAsm())
+          continue;
+        auto *target = dyn_cast<Function>(callee->stripPointerCasts());
+        if (!target) {
+          eligible = false;
+          break;
+        }
+
+        if (target->isDeclaration()) {
+          // Intrinsics are lowered by the code generator, anything else is an
+          // external call and subject to -external-calls. Native code only
+          // has concrete values to pass, which "concrete" and "all" allow.
+          if (!target->isIntrinsic() &&
+              (specialFunctionHandler->handlers.count(target) ||
+               (ExternalCalls == ExternalCallPolicy::None &&
+                !okExternals.count(target->getName().str())) ||
+               !externalDispatcher->resolveSymbol(target->getName().str()))) {
+            eligible = false;
+            break;
+          }
+        } else if (visited.insert(target).second) {
+          worklist.push_back(target);
+        }
+      }
+
+      for (const Use &op : i.operands()) {
+        if (op.get() == callee)
+          continue;
+        const auto *c = dyn_cast<Constant>(op.get());
+        if (c && usesFunctionAddress(c)) {
+          eligible = false;
+          break;
+        }
+      }
+    }
+  }
+
+  nativeFunctions[f] = {eligible, {globals.begin(), globals.end()}};
+  return eligible;
+}
+
+bool Executor::tryNativeCall(ExecutionState &state, KInstruction *ki,
+                             Function *f, std::vector<ref<Expr>> &arguments) {
+  // calls through a different function type are left to the interpreter
+  if (!isa<CallInst>(ki->inst) || arguments.size() != f->arg_size() ||
+      ki->inst->getType() != f->getReturnType() || !canRunNatively(f))
+    return false;
+
+  // same layout as for external calls
+  uint64_t *args = (uint64_t*) alloca(2*sizeof(*args) * (arguments.size() + 1));
+  memset(args, 0, 2 * sizeof(*args) * (arguments.size() + 1));
+  unsigned wordIndex = 2;
+  for (auto &argument : arguments) {
+    auto *ce = dyn_cast<ConstantExpr>(argument);
+    if (!ce)
+      return false;
+    ce->toMemory(&args[wordIndex]);
+    wordIndex += (ce->getWidth()+63)/64;
+  }
+
+  // The native code cannot fork, so it must not see any symbolic byte. It
+  // only reaches memory through the pointers it is passed, the globals it
+  // uses and errno, only those objects are checked and copied.
+  std::vector<uint64_t> pointers;
+  for (auto &argument : arguments) {
+    if (argument->getWidth() == Context::get().getPointerWidth())
+      pointers.push_back(cast<ConstantExpr>(argument)->getZExtValue());
+  }
+  for (const GlobalVariable *gv : nativeFunctions[f].globals) {
+    auto it = globalObjects.find(gv);
+    if (it != globalObjects.end())
+      pointers.push_back(it->second->address);
+  }
+#ifndef WINDOWS
+  int *errno_addr = getErrnoLocation(state);
+  pointers.push_back((uint64_t)errno_addr);
+#endif
+
+  ResolutionList reachable;
+  if (!state.addressSpace.collectReachable(std::move(pointers), reachable))
+    return false;
+
+  state.addressSpace.copyOutConcretes(reachable);
+#ifndef WINDOWS
+  ObjectPair result;
+  bool resolved = state.addressSpace.resolveOne(
+      ConstantExpr::create((uint64_t)errno_addr, Expr::Int64), result);
+  if (!resolved)
+    klee_error("Could not resolve memory object for errno");
+  externalDispatcher->setLastErrno(
+      cast<ConstantExpr>(result.second->read(0, sizeof(*errno_addr) * 8))
+          ->getZExtValue(sizeof(*errno_addr) * 8));
+#endif
+
+  auto getGlobalAddress = [this](const GlobalVariable *gv) -> void * {
+    auto it = globalAddresses.find(gv);
+    if (it == globalAddresses.end())
+      return nullptr;
+    return (void *) it->second->getZExtValue();
+  };
+  // If the native code failed the interpreter runs the call again, the state
+  // itself is still unchanged and reports the error where it happens.
+  if (!externalDispatcher->executeNativeCall(f, ki->inst, args,
+                                             getGlobalAddress))
+    return false;
+
+  if (!state.addressSpace.copyInConcretes(reachable)) {
+    terminateStateOnError(state, "native call modified read-only object",
+                          External);
+    return true;
+  }
+
+#ifndef WINDOWS
+  int error = externalDispatcher->getLastErrno();
+  state.addressSpace.copyInConcrete(result.first, result.second,
+                                    (uint64_t)&error);
+#endif
+
+  if (ki->width)
+    bindLocal(ki, state, ConstantExpr::fromMemory((void*) args, ki->width));
+  return true;
+}
+
 /***/
 
 ref<Expr> Executor::replaceReadWithSymbolic(ExecutionState &state, 
@@ -3942,36 +4519,43 @@ void Executor::executeAlloc(ExecutionState &state,
                             const ObjectState *reallocFrom,
                             size_t allocationAlignment) {
   size = toUnique(state, size);
+  const llvm::Value *allocSite = state.prevPC->inst;
+  if (allocationAlignment == 0) {
+    allocationAlignment = getAllocationAlignment(allocSite);
+  }
+
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(size)) {
-    const llvm::Value *allocSite = state.prevPC->inst;
-    if (allocationAlignment == 0) {
-      allocationAlignment = getAllocationAlignment(allocSite);
-    }
     MemoryObject *mo =
         memory->allocate(CE->getZExtValue(), isLocal, /*isGlobal=*/false,
                          allocSite, allocationAlignment);
-    if (!mo) {
-      bindLocal(target, state, 
-                ConstantExpr::alloc(0, Context::get().getPointerWidth()));
-    } else {
-      ObjectState *os = bindObjectInState(state, mo, isLocal);
-      if (zeroMemory) {
-        os->initializeToZero();
-      } else {
-        os->initializeToRandom();
-      }
-      bindLocal(target, state, mo->getBaseExpr());
-      
-      if (reallocFrom) {
-        unsigned count = std::min(reallocFrom->size, os->size);
-        for (unsigned i=0; i<count; i++)
-          os->write(i, reallocFrom->read8(i));
-        state.addressSpace.unbindObject(reallocFrom->getObject());
+    bindAllocation(state, mo, isLocal, target, zeroMemory, reallocFrom);
+  } else {
+    size = optimizer.optimizeExpr(size, true);
+
+    ExecutionState *unbounded = &state;
+    if (uint64_t capacity = MemoryManager::getSymbolicSizeCapacity()) {
+      // Sizes up to the capacity stay symbolic: the object reserves the
+      // capacity and its bounds checks use the symbolic size. Only larger
+      // sizes are concretized below.
+      StatePair bounded = fork(
+          state,
+          UleExpr::create(size, ConstantExpr::create(capacity,
+                                                     size->getWidth())),
+          true);
+      if (bounded.first) {
+        MemoryObject *mo = memory->allocateSymbolicSize(
+            ZExtExpr::create(size, Context::get().getPointerWidth()),
+            isLocal, allocSite, allocationAlignment);
+        bindAllocation(*bounded.first, mo, isLocal, target, zeroMemory,
+                       reallocFrom);
       }
+
+      unbounded = bounded.second;
+      if (!unbounded)
+        return;
     }
-  } else {
-    // XXX For now we just pick a size. Ideally we would support
-    // symbolic sizes fully but even if we don't it would be better to
+
+    // XXX For now we just pick a size. It would be better to
     // "smartly" pick a value, for example we could fork and pick the
     // min and max values and perhaps some intermediate (reasonable
     // value).
@@ -3981,11 +4565,9 @@ void Executor::executeAlloc(ExecutionState &state,
     // return argument first). This shows up in pcre when llvm
     // collapses the size expression with a select.
 
-    size = optimizer.optimizeExpr(size, true);
-
     ref<ConstantExpr> example;
-    bool success =
-        solver->getValue(state.constraints, size, example, state.queryMetaData);
+    bool success = solver->getValue(unbounded->constraints, size, example,
+                                    unbounded->queryMetaData);
     assert(success && "FIXME: Unhandled solver failure");
     (void) success;
     
@@ -3995,8 +4577,8 @@ void Executor::executeAlloc(ExecutionState &state,
       ref<ConstantExpr> tmp = example->LShr(ConstantExpr::alloc(1, W));
       bool res;
       bool success =
-          solver->mayBeTrue(state.constraints, EqExpr::create(tmp, size), res,
-                            state.queryMetaData);
+          solver->mayBeTrue(unbounded->constraints, EqExpr::create(tmp, size),
+                            res, unbounded->queryMetaData);
       assert(success && "FIXME: Unhandled solver failure");      
       (void) success;
       if (!res)
@@ -4004,7 +4586,8 @@ void Executor::executeAlloc(ExecutionState &state,
       example = tmp;
     }
 
-    StatePair fixedSize = fork(state, EqExpr::create(example, size), true);
+    StatePair fixedSize =
+        fork(*unbounded, EqExpr::create(example, size), true);
     
     if (fixedSize.second) { 
       // Check for exactly two values
@@ -4054,6 +4637,32 @@ void Executor::executeAlloc(ExecutionState &state,
   }
 }
 
+void Executor::bindAllocation(ExecutionState &state, MemoryObject *mo,
+                              bool isLocal, KInstruction *target,
+                              bool zeroMemory,
+                              const ObjectState *reallocFrom) {
+  if (!mo) {
+    bindLocal(target, state, 
+              ConstantExpr::alloc(0, Context::get().getPointerWidth()));
+    return;
+  }
+
+  ObjectState *os = bindObjectInState(state, mo, isLocal);
+  if (zeroMemory) {
+    os->initializeToZero();
+  } else {
+    os->initializeToRandom();
+  }
+  bindLocal(target, state, mo->getBaseExpr());
+
+  if (reallocFrom) {
+    unsigned count = std::min(reallocFrom->size, os->size);
+    for (unsigned i=0; i<count; i++)
+      os->write(i, reallocFrom->read8(i));
+    state.addressSpace.unbindObject(reallocFrom->getObject());
+  }
+}
+
 void Executor::executeFree(ExecutionState &state,
                            ref<Expr> address,
                            KInstruction *target) {
@@ -4119,9 +4728,9 @@ void Executor::executeMemoryOperation(ExecutionState &state,
                                       bool isWrite,
                                       ref<Expr> address,
                                       ref<Expr> value /* undef if read */,
-                                      KInstruction *target /* undef if write */) {
-  Expr::Width type = (isWrite ? value->getWidth() : 
-                     getWidthForLLVMType(target->inst->getType()));
+                                      KInstruction *target /* undef if write */,
+                                      ref<ConstantExpr> segment) {
+  Expr::Width type = (isWrite ? value->getWidth() : target->width);
   unsigned bytes = Expr::getMinBytesForWidth(type);
 
   if (SimplifySymIndices) {
@@ -4137,7 +4746,14 @@ void Executor::executeMemoryOperation(ExecutionState &state,
   ObjectPair op;
   bool success;
   solver->setTimeout(coreSolverTimeout);
-  if (!state.addressSpace.resolveOne(state, solver, address, op, success)) {
+  if (!segment.isNull() && !isa<ConstantExpr>(address) &&
+      state.addressSpace.resolveOne(segment, op)) {
+    // The pointer was derived from an address inside this object. If it
+    // turns out to leave the object, the bounds check below fails and the
+    // general resolution takes over.
+    success = true;
+  } else if (!state.addressSpace.resolveOne(state, solver, address, op,
+                                            success)) {
     address = toConstant(state, address, "resolveOne failure");
     success = state.addressSpace.resolveOne(cast<ConstantExpr>(address), op);
   }
@@ -4250,9 +4866,10 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
     // or if that fails try adding a unique identifier.
     unsigned id = 0;
     std::string uniqueName = name;
-    while (!state.arrayNames.insert(uniqueName).second) {
+    while (state.arrayNames.count(uniqueName)) {
       uniqueName = name + "_" + llvm::utostr(++id);
     }
+    state.arrayNames = state.arrayNames.insert(uniqueName);
     const Array *array = arrayCache.CreateArray(uniqueName, mo->size);
     bindObjectInState(state, mo, false, array);
     state.addSymbolic(mo, array);
@@ -4485,8 +5102,8 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
   // the preferred constraints.  See test/Features/PreferCex.c for
   // an example) While this process can be very expensive, it can
   // also make understanding individual test cases much easier.
-  for (unsigned i = 0; i != state.symbolics.size(); ++i) {
-    const auto &mo = state.symbolics[i].first;
+  for (const auto &symbolic : state.symbolics) {
+    const auto &mo = symbolic.first;
     std::vector< ref<Expr> >::const_iterator pi = 
       mo->cexPreferences.begin(), pie = mo->cexPreferences.end();
     for (; pi != pie; ++pi) {
@@ -4510,8 +5127,8 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
 
   std::vector< std::vector<unsigned char> > values;
   std::vector<const Array*> objects;
-  for (unsigned i = 0; i != state.symbolics.size(); ++i)
-    objects.push_back(state.symbolics[i].second);
+  for (const auto &symbolic : state.symbolics)
+    objects.push_back(symbolic.second);
   bool success = solver->getInitialValues(extendedConstraints, objects, values,
                                           state.queryMetaData);
   solver->setTimeout(time::Span());
@@ -4522,8 +5139,9 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
     return false;
   }
   
-  for (unsigned i = 0; i != state.symbolics.size(); ++i)
-    res.push_back(std::make_pair(state.symbolics[i].first->name, values[i]));
+  unsigned i = 0;
+  for (const auto &symbolic : state.symbolics)
+    res.push_back(std::make_pair(symbolic.first->name, values[i++]));
   return true;
 }
 
@@ -15,7 +15,9 @@
 #ifndef KLEE_EXECUTOR_H
 #define KLEE_EXECUTOR_H
 
+#include "Checkpoint.h"
 #include "ExecutionState.h"
+#include "StateSet.h"
 #include "UserSearcher.h"
 
 #include "klee/ADT/RNG.h"
@@ -30,6 +32,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
@@ -56,6 +59,8 @@ namespace llvm {
 
     class GlobalValue;
 
+    class GlobalVariable;
+
     class Instruction;
 
     class LLVMContext;
@@ -103,6 +108,8 @@ namespace klee {
 
     struct StackFrame;
 
+    class StateSerializer;
+
     class StatsTracker;
 
     class TimingSolver;
@@ -171,13 +178,21 @@ namespace klee {
         ExternalDispatcher *externalDispatcher;
         TimingSolver *solver;
         MemoryManager *memory;
-        std::set<ExecutionState *, ExecutionStateIDCompare> states;
+        StateSet states;
         StatsTracker *statsTracker;
         TreeStreamWriter *pathWriter, *symPathWriter;
         SpecialFunctionHandler *specialFunctionHandler;
         TimerGroup timers;
         std::unique_ptr<PTree> processTree;
 
+        /// Writes states to disk when over the memory cap, null unless
+        /// -spill-states is set. \see checkMemoryUsage()
+        std::unique_ptr<StateSerializer> stateSerializer;
+
+        /// States written to disk, oldest first. They remain in \ref states
+        /// but are taken out of the searcher until they are resumed.
+        std::deque<ExecutionState *> spilledStates;
+
         /// Used to track states that have been added during the current
         /// instructions step.
         /// \invariant \ref addedStates is a subset of \ref states.
@@ -198,6 +213,22 @@ namespace klee {
         /// on as-yet-to-be-determined flags.
         std::map<ExecutionState *, std::vector<SeedInfo> > seedMap;
 
+        /// Whether states record their decisions at symbolic branches, set
+        /// when checkpoints are written. \see writeCheckpoint()
+        bool recordDecisions;
+
+        /// Decisions of the states of the checkpoint this run resumes from,
+        /// null when not resuming.
+        std::unique_ptr<CheckpointTree> resumeTree;
+
+        /// States that still replay the decisions of \ref resumeTree, with
+        /// their position in it. Like the states of \ref seedMap they are
+        /// executed before the searcher is set up, oldest state first, so the
+        /// replay does not depend on where the states were allocated.
+        std::map<ExecutionState *, CheckpointTree::NodeID,
+                 ExecutionStateIDCompare>
+            resumingStates;
+
         /// Map of globals to their representative memory object.
         std::map<const llvm::GlobalValue *, MemoryObject *> globalObjects;
 
@@ -209,6 +240,15 @@ namespace klee {
         /// Used to validate and dereference function pointers.
         std::unordered_map<std::uint64_t, llvm::Function *> legalFunctions;
 
+        /// Functions that were checked for native execution, see
+        /// canRunNatively.
+        struct NativeFunction {
+          bool eligible;
+          /// the globals the function and its callees refer to
+          std::vector<const llvm::GlobalVariable *> globals;
+        };
+        std::map<const llvm::Function *, NativeFunction> nativeFunctions;
+
         /// When non-null the bindings that will be used for calls to
         /// klee_make_symbolic in order replay.
         const struct KTest *replayKTest;
@@ -310,6 +350,21 @@ namespace klee {
                                   llvm::Function *function,
                                   std::vector<ref<Expr> > &arguments);
 
+        /// Whether the function and everything it calls can be compiled and
+        /// run natively: no special functions, no unresolvable externals or
+        /// externals the external call policy forbids, no function pointers
+        /// and no exception handling.
+        bool canRunNatively(llvm::Function *f);
+
+        /// Executes a call to an internal function natively if its arguments
+        /// and the memory it can reach are concrete: the objects the
+        /// arguments and the globals it uses point to, and the objects
+        /// their contents point to in turn.
+        /// \return false if the call has to be interpreted
+        bool tryNativeCall(ExecutionState &state, KInstruction *ki,
+                           llvm::Function *f,
+                           std::vector<ref<Expr> > &arguments);
+
         ObjectState *bindObjectInState(ExecutionState &state, const MemoryObject *mo,
                                        bool isLocal, const Array *array = 0);
 
@@ -356,6 +411,13 @@ namespace klee {
                           const ObjectState *reallocFrom = 0,
                           size_t allocationAlignment = 0);
 
+        /// Binds the newly allocated `mo` in `state` and its address (or a
+        /// null pointer if the allocation failed) to `target`, see
+        /// executeAlloc.
+        void bindAllocation(ExecutionState &state, MemoryObject *mo,
+                            bool isLocal, KInstruction *target,
+                            bool zeroMemory, const ObjectState *reallocFrom);
+
         /// Free the given address with checking for errors. If target is
         /// given it will be bound to 0 in the resulting states (this is a
         /// convenience for realloc). Note that this function can cause the
@@ -386,7 +448,8 @@ namespace klee {
                                     bool isWrite,
                                     ref<Expr> address,
                                     ref<Expr> value /* undef if read */,
-                                    KInstruction *target /* undef if write */);
+                                    KInstruction *target /* undef if write */,
+                                    ref<ConstantExpr> segment = nullptr);
 
         void executeMakeSymbolic(ExecutionState &state, const MemoryObject *mo,
                                  const std::string &name);
@@ -404,6 +467,21 @@ namespace klee {
         // current state, and one of the states may be null.
         StatePair fork(ExecutionState &current, ref<Expr> condition, bool isInternal);
 
+        /// Whether a branch on condition may be forked without checking the
+        /// feasibility of its sides, see -speculative-fork.
+        bool canForkSpeculatively(const ExecutionState &current,
+                                  ref<Expr> condition) const;
+
+        /// Forks current like fork, but without querying the solver. Both
+        /// states keep their side of the condition as unverified condition
+        /// until verifyCondition is called for them.
+        StatePair forkSpeculatively(ExecutionState &current, ref<Expr> condition);
+
+        /// Checks the unverified condition of a state from a speculative fork
+        /// and adds it as a constraint.
+        /// \return false if the state was dropped as infeasible or terminated
+        bool verifyCondition(ExecutionState &state);
+
         // If the MaxStatic*Pct limits have been reached, concretize the condition and
         // return it. Otherwise, return the unmodified condition.
         ref<Expr> maxStaticPctChecks(ExecutionState &current, ref<Expr> condition);
@@ -424,17 +502,28 @@ namespace klee {
         Cell &getArgumentCell(ExecutionState &state,
                               KFunction *kf,
                               unsigned index) {
-            return state.stack.back().locals[kf->getArgRegister(index)];
+            return state.stack.back().getWritableLocal(kf->getArgRegister(index));
         }
 
         Cell &getDestCell(ExecutionState &state,
                           KInstruction *target) {
-            return state.stack.back().locals[target->dest];
+            return state.stack.back().getWritableLocal(target->dest);
         }
 
         void bindLocal(KInstruction *target,
                        ExecutionState &state,
-                       ref<Expr> value);
+                       ref<Expr> value,
+                       ref<ConstantExpr> segment = nullptr);
+
+        /// The segment an operand carries, see StackFrame::getSegment.
+        /// Constants carry none.
+        ref<ConstantExpr> evalSegment(KInstruction *ki, unsigned index,
+                                      ExecutionState &state) const;
+
+        /// The segment of a pointer operand for -segmented-pointers: the
+        /// segment it carries or its own value if it is a concrete address.
+        ref<ConstantExpr> getSegment(KInstruction *ki, unsigned index,
+                                     ExecutionState &state) const;
 
         void bindArgument(KFunction *kf,
                           unsigned index,
@@ -484,6 +573,10 @@ namespace klee {
         // remove state from queue and delete
         void terminateState(ExecutionState &state);
 
+        // remove state from queue and delete without counting it as an
+        // explored path
+        void discardState(ExecutionState &state);
+
         // call exit handler and terminate state
         void terminateStateEarly(ExecutionState &state, const llvm::Twine &message);
 
@@ -524,10 +617,18 @@ namespace klee {
                                           ref<Expr> e,
                                           ref<ConstantExpr> value);
 
-        /// check memory usage and terminate states when over threshold of -max-memory + 100MB
+        /// check memory usage and terminate (or spill) states when over threshold of -max-memory + 100MB
         /// \return true if below threshold, false otherwise (states were terminated)
         bool checkMemoryUsage();
 
+        /// Writes the state to disk and takes it out of the searcher.
+        /// \return false if the state cannot be spilled
+        bool spillState(ExecutionState &state);
+
+        /// Reads up to count spilled states back in, oldest first, and hands
+        /// them to the searcher again.
+        void resumeSpilledStates(std::size_t count);
+
         /// check if branching/forking is allowed
         bool branchingPermitted(const ExecutionState &state) const;
 
@@ -535,6 +636,14 @@ namespace klee {
 
         void doDumpStates();
 
+        /// Records a decision taken by the state at a symbolic branch and
+        /// follows it in \ref resumeTree if the state is resuming.
+        void recordDecision(ExecutionState &state, std::uint32_t decision);
+
+        /// Writes the decisions of all states and the statistics to the
+        /// output directory, replacing the previous checkpoint.
+        void writeCheckpoint();
+
         /// Only for debug purposes; enable via debugger or klee-control
         void dumpStates();
 
@@ -21,9 +21,13 @@
 #include "llvm/IR/Module.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 
 #include <csetjmp>
 #include <csignal>
@@ -48,8 +52,17 @@ class ExternalDispatcherImpl {
 private:
   typedef std::map<const llvm::Instruction *, llvm::Function *> dispatchers_ty;
   dispatchers_ty dispatchers;
+  typedef std::map<std::pair<const llvm::Instruction *, const llvm::Function *>,
+                   llvm::Function *>
+      native_dispatchers_ty;
+  native_dispatchers_ty nativeDispatchers;
+  typedef std::function<void *(const llvm::GlobalVariable *)>
+      global_resolver_ty;
   llvm::Function *createDispatcher(llvm::Function *f, llvm::Instruction *i,
                                    llvm::Module *module);
+  llvm::Function *cloneForNativeCall(llvm::Function *f, llvm::Module *module,
+                                     const global_resolver_ty &getGlobalAddress);
+  void compileDispatcher(llvm::Function *dispatcher, llvm::Module *module);
   llvm::ExecutionEngine *executionEngine;
   LLVMContext &ctx;
   std::map<std::string, void *> preboundFunctions;
@@ -64,6 +77,9 @@ public:
   ~ExternalDispatcherImpl();
   bool executeCall(llvm::Function *function, llvm::Instruction *i,
                    uint64_t *args);
+  bool executeNativeCall(llvm::Function *function, llvm::Instruction *i,
+                         uint64_t *args,
+                         const global_resolver_ty &getGlobalAddress);
   void *resolveSymbol(const std::string &name);
   int getLastErrno();
   void setLastErrno(int newErrno);
@@ -185,7 +201,31 @@ bool ExternalDispatcherImpl::executeCall(Function *f, Instruction *i,
   dispatchModule = new Module(getFreshModuleID(), ctx);
   dispatcher = createDispatcher(f, i, dispatchModule);
   dispatchers.insert(std::make_pair(i, dispatcher));
+  compileDispatcher(dispatcher, dispatchModule);
 
+  return runProtectedCall(dispatcher, args);
+}
+
+bool ExternalDispatcherImpl::executeNativeCall(
+    Function *f, Instruction *i, uint64_t *args,
+    const global_resolver_ty &getGlobalAddress) {
+  auto key = std::make_pair(i, f);
+  native_dispatchers_ty::iterator it = nativeDispatchers.find(key);
+  if (it != nativeDispatchers.end())
+    return runProtectedCall(it->second, args);
+
+  Module *dispatchModule = new Module(getFreshModuleID(), ctx);
+  Function *native = cloneForNativeCall(f, dispatchModule, getGlobalAddress);
+  Function *dispatcher =
+      native ? createDispatcher(native, i, dispatchModule) : nullptr;
+  nativeDispatchers.insert(std::make_pair(key, dispatcher));
+  compileDispatcher(dispatcher, dispatchModule);
+
+  return runProtectedCall(dispatcher, args);
+}
+
+void ExternalDispatcherImpl::compileDispatcher(Function *dispatcher,
+                                               Module *dispatchModule) {
   // Force the JIT execution engine to go ahead and build the function. This
   // ensures that any errors or assertions in the compilation process will
   // trigger crashes instead of being caught as aborts in the external
@@ -206,7 +246,89 @@ bool ExternalDispatcherImpl::executeCall(Function *f, Instruction *i,
     // MCJIT didn't take ownership of the module so delete it.
     delete dispatchModule;
   }
-  return runProtectedCall(dispatcher, args);
+}
+
+// Copies f and every function defined in its module that f reaches into
+// module. Declarations stay declarations and are resolved by the JIT like any
+// other external function, global variables are replaced by the addresses the
+// executor gave them, so the native code works on the same memory the
+// executor copied out. Returns null if a global variable has no address.
+Function *
+ExternalDispatcherImpl::cloneForNativeCall(Function *f, Module *module,
+                                           const global_resolver_ty &getGlobalAddress) {
+  Module *original = f->getParent();
+  module->setDataLayout(original->getDataLayout());
+  module->setTargetTriple(original->getTargetTriple());
+
+  ValueToValueMapTy valueMap;
+  for (GlobalVariable &gv : original->globals()) {
+    void *address = getGlobalAddress(&gv);
+    if (!address)
+      return nullptr;
+    valueMap[&gv] = ConstantExpr::getIntToPtr(
+        ConstantInt::get(Type::getInt64Ty(ctx), (uintptr_t)address),
+        gv.getType());
+  }
+
+  std::vector<Function *> worklist;
+  std::vector<std::pair<Function *, Function *>> clones;
+  auto mapFunction = [&](Function *g) {
+    if (valueMap.count(g))
+      return;
+
+    if (g->isDeclaration()) {
+      Function *declaration = Function::Create(
+          g->getFunctionType(), GlobalValue::ExternalLinkage, g->getName(),
+          module);
+      declaration->setAttributes(g->getAttributes());
+      valueMap[g] = declaration;
+    } else {
+      // unique names across all modules, see createDispatcher
+      Function *clone = Function::Create(
+          g->getFunctionType(), GlobalValue::InternalLinkage,
+          "native_" + g->getName().str() + module->getModuleIdentifier(),
+          module);
+      valueMap[g] = clone;
+      worklist.push_back(g);
+      clones.emplace_back(g, clone);
+    }
+  };
+
+  mapFunction(f);
+  while (!worklist.empty()) {
+    Function *g = worklist.back();
+    worklist.pop_back();
+    for (auto it = inst_begin(g), ie = inst_end(g); it != ie; ++it) {
+      for (Value *operand : it->operands()) {
+        if (auto *callee = dyn_cast<Function>(operand))
+          mapFunction(callee);
+      }
+    }
+  }
+
+  for (auto &pair : clones) {
+    Function *clone = pair.second;
+    auto cloneArg = clone->arg_begin();
+    for (Argument &arg : pair.first->args()) {
+      cloneArg->setName(arg.getName());
+      valueMap[&arg] = &*cloneArg++;
+    }
+
+    SmallVector<ReturnInst *, 8> returns;
+#if LLVM_VERSION_CODE >= LLVM_VERSION(13, 0)
+    CloneFunctionInto(clone, pair.first, valueMap,
+                      CloneFunctionChangeType::DifferentModule, returns);
+#else
+    CloneFunctionInto(clone, pair.first, valueMap, true, returns);
+#endif
+    // the clone may have kept a more visible linkage of the original
+    clone->setLinkage(GlobalValue::InternalLinkage);
+  }
+
+  // the debug information refers to the executed module
+  StripDebugInfo(*module);
+
+  return cast<Function>(valueMap[f]);
 }
 
 // FIXME: This is not reentrant.
@@ -255,7 +377,7 @@ bool ExternalDispatcherImpl::runProtectedCall(Function *f, uint64_t *args) {
 Function *ExternalDispatcherImpl::createDispatcher(Function *target,
                                                    Instruction *inst,
                                                    Module *module) {
-  if (!resolveSymbol(target->getName().str()))
+  if (target->isDeclaration() && !resolveSymbol(target->getName().str()))
     return 0;
 
 #if LLVM_VERSION_CODE >= LLVM_VERSION(8, 0)
@@ -344,6 +466,13 @@ bool ExternalDispatcher::executeCall(llvm::Function *function,
   return impl->executeCall(function, i, args);
 }
 
+bool ExternalDispatcher::executeNativeCall(
+    llvm::Function *function, llvm::Instruction *i, uint64_t *args,
+    const std::function<void *(const llvm::GlobalVariable *)>
+        &getGlobalAddress) {
+  return impl->executeNativeCall(function, i, args, getGlobalAddress);
+}
+
 void *ExternalDispatcher::resolveSymbol(const std::string &name) {
   return impl->resolveSymbol(name);
 }
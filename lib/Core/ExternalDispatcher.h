@@ -12,12 +12,14 @@
 
 #include "klee/Config/Version.h"
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <stdint.h>
 #include <string>
 
 namespace llvm {
+class GlobalVariable;
 class Instruction;
 class LLVMContext;
 class Function;
@@ -39,6 +41,15 @@ public:
    */
   bool executeCall(llvm::Function *function, llvm::Instruction *i,
                    uint64_t *args);
+  /* Call the given function of the executed module natively, using the same
+   * convention as executeCall. The function and all functions it calls are
+   * compiled with their global variables placed at the addresses returned by
+   * getGlobalAddress.
+   */
+  bool executeNativeCall(
+      llvm::Function *function, llvm::Instruction *i, uint64_t *args,
+      const std::function<void *(const llvm::GlobalVariable *)>
+          &getGlobalAddress);
   void *resolveSymbol(const std::string &name);
 
   int getLastErrno();
@@ -10,10 +10,10 @@
 #include "Memory.h"
 
 #include "Context.h"
+#include "CoreStats.h"
 #include "ExecutionState.h"
 #include "MemoryManager.h"
 
-#include "klee/ADT/BitArray.h"
 #include "klee/Expr/ArrayCache.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Support/OptionCategories.h"
@@ -38,6 +38,24 @@ namespace {
                     cl::desc("Use constant arrays instead of updates when possible (default=true)\n"),
                     cl::init(true),
                     cl::cat(SolvingCat));
+
+  cl::opt<unsigned>
+  MaxIteReadSize("max-ite-read-size",
+                 cl::desc("Encode reads at symbolic offsets from objects of "
+                          "up to this many bytes as if-then-else chains over "
+                          "the bytes instead of array reads, as long as all "
+                          "bytes are known without the update list "
+                          "(0=off, default=16)"),
+                 cl::init(16),
+                 cl::cat(SolvingCat));
+
+  cl::opt<unsigned>
+  CompactUpdatesDepth("compact-updates-depth",
+                      cl::desc("Compact the update list of an object once it "
+                               "is this deep, and again whenever it has "
+                               "doubled since (0=off, default=128)"),
+                      cl::init(128),
+                      cl::cat(SolvingCat));
 }
 
 /***/
@@ -76,11 +94,11 @@ void MemoryObject::getAllocInfo(std::string &result) const {
 ObjectState::ObjectState(const MemoryObject *mo)
   : copyOnWriteOwner(0),
     object(mo),
-    concreteStore(new uint8_t[mo->size]),
-    concreteMask(0),
-    flushMask(0),
+    concreteStore(mo->size),
+    byteStates(0),
     knownSymbolics(0),
     updates(0, 0),
+    nextCompaction(CompactUpdatesDepth),
     size(mo->size),
     readOnly(false) {
   if (!UseConstantArrays) {
@@ -89,49 +107,40 @@ ObjectState::ObjectState(const MemoryObject *mo)
         getArrayCache()->CreateArray("tmp_arr" + llvm::utostr(++id), size);
     updates = UpdateList(array, 0);
   }
-  memset(concreteStore, 0, size);
 }
 
 
 ObjectState::ObjectState(const MemoryObject *mo, const Array *array)
   : copyOnWriteOwner(0),
     object(mo),
-    concreteStore(new uint8_t[mo->size]),
-    concreteMask(0),
-    flushMask(0),
+    concreteStore(mo->size),
+    byteStates(0),
     knownSymbolics(0),
     updates(array, 0),
+    nextCompaction(CompactUpdatesDepth),
     size(mo->size),
     readOnly(false) {
   makeSymbolic();
-  memset(concreteStore, 0, size);
 }
 
 ObjectState::ObjectState(const ObjectState &os) 
   : copyOnWriteOwner(0),
     object(os.object),
-    concreteStore(new uint8_t[os.size]),
-    concreteMask(os.concreteMask ? new BitArray(*os.concreteMask, os.size) : 0),
-    flushMask(os.flushMask ? new BitArray(*os.flushMask, os.size) : 0),
-    knownSymbolics(0),
+    concreteStore(os.concreteStore),
+    byteStates(os.byteStates ? new ByteStates(*os.byteStates) : 0),
+    knownSymbolics(os.knownSymbolics
+                       ? new SymbolicStore(*os.knownSymbolics)
+                       : 0),
     updates(os.updates),
+    nextCompaction(os.nextCompaction),
     size(os.size),
     readOnly(false) {
   assert(!os.readOnly && "no need to copy read only object?");
-  if (os.knownSymbolics) {
-    knownSymbolics = new ref<Expr>[size];
-    for (unsigned i=0; i<size; i++)
-      knownSymbolics[i] = os.knownSymbolics[i];
-  }
-
-  memcpy(concreteStore, os.concreteStore, size*sizeof(*concreteStore));
 }
 
 ObjectState::~ObjectState() {
-  delete concreteMask;
-  delete flushMask;
-  delete[] knownSymbolics;
-  delete[] concreteStore;
+  delete byteStates;
+  delete knownSymbolics;
 }
 
 ArrayCache *ObjectState::getArrayCache() const {
@@ -192,6 +201,75 @@ const UpdateList &ObjectState::getUpdates() const {
   return updates;
 }
 
+void ObjectState::compactUpdates() const {
+  if (!CompactUpdatesDepth || updates.getSize() < nextCompaction)
+    return;
+
+  // The nodes, newest first.
+  std::vector<ref<UpdateNode>> nodes;
+  for (ref<UpdateNode> un = updates.head; !un.isNull(); un = un->next)
+    nodes.push_back(un);
+
+  // A write to a constant index is never read if a newer write to the same
+  // constant index exists, no matter what lies in between.
+  std::vector<bool> keep(nodes.size(), true);
+  std::vector<bool> written(size, false);
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    auto *index = dyn_cast<ConstantExpr>(nodes[i]->index);
+    if (!index || index->getZExtValue() >= size)
+      continue;
+    uint64_t offset = index->getZExtValue();
+    if (written[offset])
+      keep[i] = false;
+    written[offset] = true;
+  }
+
+  // With a constant array as root, the oldest writes of constant values to
+  // constant indices are folded into a new constant array.
+  unsigned end = nodes.size();
+  const Array *root = updates.root;
+  if (root && root->isConstantArray()) {
+    std::vector<ref<ConstantExpr>> contents(root->constantValues);
+    unsigned folded = end;
+    for (; folded != 0; --folded) {
+      const UpdateNode *un = nodes[folded - 1].get();
+      if (!keep[folded - 1])
+        continue;
+      auto *index = dyn_cast<ConstantExpr>(un->index);
+      auto *value = dyn_cast<ConstantExpr>(un->value);
+      if (!index || !value || index->getZExtValue() >= size)
+        break;
+      contents[index->getZExtValue()] = value;
+    }
+
+    if (folded != end) {
+      static unsigned id = 0;
+      root = getArrayCache()->CreateArray("const_arr_c" + llvm::utostr(++id),
+                                          size, &contents[0],
+                                          &contents[0] + contents.size());
+      end = folded;
+    }
+  }
+
+  // Keep the oldest nodes that are unchanged, rebuild the rest.
+  UpdateList compacted(root, 0);
+  unsigned rebuilt = end;
+  if (root == updates.root) {
+    while (rebuilt != 0 && keep[rebuilt - 1])
+      --rebuilt;
+    if (rebuilt != end)
+      compacted.head = nodes[rebuilt];
+  }
+  for (unsigned i = rebuilt; i != 0; --i) {
+    if (keep[i - 1])
+      compacted.extend(nodes[i - 1]->index, nodes[i - 1]->value);
+  }
+
+  updates = compacted;
+  nextCompaction = std::max<unsigned>(CompactUpdatesDepth,
+                                      2 * updates.getSize());
+}
+
 void ObjectState::flushToConcreteStore(TimingSolver *solver,
                                        const ExecutionState &state) const {
   for (unsigned i = 0; i < size; i++) {
@@ -204,17 +282,15 @@ void ObjectState::flushToConcreteStore(TimingSolver *solver,
                      "byte %p+%u will have random value",
                      (void *)object->address, i);
       else
-        ce->toMemory(concreteStore + i);
+        concreteStore.set(i, ce->getZExtValue(8));
     }
   }
 }
 
 void ObjectState::makeConcrete() {
-  delete concreteMask;
-  delete flushMask;
-  delete[] knownSymbolics;
-  concreteMask = 0;
-  flushMask = 0;
+  delete byteStates;
+  delete knownSymbolics;
+  byteStates = 0;
   knownSymbolics = 0;
 }
 
@@ -222,25 +298,21 @@ void ObjectState::makeSymbolic() {
   assert(!updates.head &&
          "XXX makeSymbolic of objects with symbolic values is unsupported");
 
-  // XXX simplify this, can just delete various arrays I guess
-  for (unsigned i=0; i<size; i++) {
-    markByteSymbolic(i);
-    setKnownSymbolic(i, 0);
-    markByteFlushed(i);
-  }
+  delete byteStates;
+  delete knownSymbolics;
+  byteStates = new ByteStates(size, SymbolicByte | FlushedByte);
+  knownSymbolics = 0;
 }
 
 void ObjectState::initializeToZero() {
   makeConcrete();
-  memset(concreteStore, 0, size);
+  concreteStore.fill(0);
 }
 
 void ObjectState::initializeToRandom() {  
   makeConcrete();
-  for (unsigned i=0; i<size; i++) {
-    // randomly selected by 256 sided die
-    concreteStore[i] = 0xAB;
-  }
+  // randomly selected by 256 sided die
+  concreteStore.fill(0xAB);
 }
 
 /*
@@ -260,28 +332,24 @@ void ObjectState::fastRangeCheckOffset(ref<Expr> offset,
 
 void ObjectState::flushRangeForRead(unsigned rangeBase, 
                                     unsigned rangeSize) const {
-  if (!flushMask) flushMask = new BitArray(size, true);
- 
   for (unsigned offset=rangeBase; offset<rangeBase+rangeSize; offset++) {
     if (!isByteFlushed(offset)) {
       if (isByteConcrete(offset)) {
         updates.extend(ConstantExpr::create(offset, Expr::Int32),
                        ConstantExpr::create(concreteStore[offset], Expr::Int8));
       } else {
-        assert(isByteKnownSymbolic(offset) && "invalid bit set in flushMask");
+        assert(isByteKnownSymbolic(offset) && "unflushed byte without cache value");
         updates.extend(ConstantExpr::create(offset, Expr::Int32),
-                       knownSymbolics[offset]);
+                       (*knownSymbolics)[offset]);
       }
 
-      flushMask->unset(offset);
+      markByteFlushed(offset);
     }
   } 
 }
 
 void ObjectState::flushRangeForWrite(unsigned rangeBase, 
                                      unsigned rangeSize) {
-  if (!flushMask) flushMask = new BitArray(size, true);
-
   for (unsigned offset=rangeBase; offset<rangeBase+rangeSize; offset++) {
     if (!isByteFlushed(offset)) {
       if (isByteConcrete(offset)) {
@@ -289,13 +357,13 @@ void ObjectState::flushRangeForWrite(unsigned rangeBase,
                        ConstantExpr::create(concreteStore[offset], Expr::Int8));
         markByteSymbolic(offset);
       } else {
-        assert(isByteKnownSymbolic(offset) && "invalid bit set in flushMask");
+        assert(isByteKnownSymbolic(offset) && "unflushed byte without cache value");
         updates.extend(ConstantExpr::create(offset, Expr::Int32),
-                       knownSymbolics[offset]);
+                       (*knownSymbolics)[offset]);
         setKnownSymbolic(offset, 0);
       }
 
-      flushMask->unset(offset);
+      markByteFlushed(offset);
     } else {
       // flushed bytes that are written over still need
       // to be marked out
@@ -309,49 +377,58 @@ void ObjectState::flushRangeForWrite(unsigned rangeBase,
 }
 
 bool ObjectState::isByteConcrete(unsigned offset) const {
-  return !concreteMask || concreteMask->get(offset);
+  return !byteStates || !(byteStates->get(offset) & SymbolicByte);
+}
+
+bool ObjectState::isConcrete() const {
+  if (!byteStates)
+    return true;
+  for (unsigned i = 0; i < size; i++)
+    if (byteStates->get(i) & SymbolicByte)
+      return false;
+  return true;
 }
 
 bool ObjectState::isByteFlushed(unsigned offset) const {
-  return flushMask && !flushMask->get(offset);
+  return byteStates && (byteStates->get(offset) & FlushedByte);
 }
 
 bool ObjectState::isByteKnownSymbolic(unsigned offset) const {
-  return knownSymbolics && knownSymbolics[offset].get();
+  return knownSymbolics && (*knownSymbolics)[offset].get();
 }
 
 void ObjectState::markByteConcrete(unsigned offset) {
-  if (concreteMask)
-    concreteMask->set(offset);
+  if (byteStates)
+    byteStates->set(offset, byteStates->get(offset) & ~SymbolicByte);
 }
 
 void ObjectState::markByteSymbolic(unsigned offset) {
-  if (!concreteMask)
-    concreteMask = new BitArray(size, true);
-  concreteMask->unset(offset);
+  if (!byteStates)
+    byteStates = new ByteStates(size);
+  byteStates->set(offset, byteStates->get(offset) | SymbolicByte);
 }
 
 void ObjectState::markByteUnflushed(unsigned offset) {
-  if (flushMask)
-    flushMask->set(offset);
+  if (byteStates)
+    byteStates->set(offset, byteStates->get(offset) & ~FlushedByte);
 }
 
-void ObjectState::markByteFlushed(unsigned offset) {
-  if (!flushMask) {
-    flushMask = new BitArray(size, false);
-  } else {
-    flushMask->unset(offset);
-  }
+void ObjectState::markByteFlushed(unsigned offset) const {
+  if (!byteStates)
+    byteStates = new ByteStates(size);
+  byteStates->set(offset, byteStates->get(offset) | FlushedByte);
 }
 
 void ObjectState::setKnownSymbolic(unsigned offset, 
                                    Expr *value /* can be null */) {
   if (knownSymbolics) {
-    knownSymbolics[offset] = value;
+    // clearing an already empty entry must not copy its page
+    if (value || (*knownSymbolics)[offset].get())
+      knownSymbolics->set(offset, value);
   } else {
     if (value) {
-      knownSymbolics = new ref<Expr>[size];
-      knownSymbolics[offset] = value;
+      knownSymbolics = new SymbolicStore(size);
+      knownSymbolics->set(offset, value);
     }
   }
 }
@@ -362,17 +439,44 @@ ref<Expr> ObjectState::read8(unsigned offset) const {
   if (isByteConcrete(offset)) {
     return ConstantExpr::create(concreteStore[offset], Expr::Int8);
   } else if (isByteKnownSymbolic(offset)) {
-    return knownSymbolics[offset];
+    return (*knownSymbolics)[offset];
   } else {
     assert(isByteFlushed(offset) && "unflushed byte without cache value");
-    
-    return ReadExpr::create(getUpdates(), 
-                            ConstantExpr::create(offset, Expr::Int32));
+
+    const UpdateList &ul = getUpdates();
+    ++stats::updateListReads;
+    stats::updateListDepth += ul.getSize();
+    return ReadExpr::create(ul, ConstantExpr::create(offset, Expr::Int32));
   }    
 }
 
+bool ObjectState::isIteEncodable() const {
+  if (size == 0 || size > MaxIteReadSize)
+    return false;
+
+  // bytes only known from the update list would each need an array read
+  for (unsigned i = 0; i < size; i++)
+    if (!isByteConcrete(i) && !isByteKnownSymbolic(i))
+      return false;
+  return true;
+}
+
+ref<Expr> ObjectState::readIte(ref<Expr> offset) const {
+  // The offset is in bounds, so the last byte does not need a comparison.
+  ref<Expr> result = read8(size - 1);
+  for (unsigned i = size - 1; i != 0; --i) {
+    ref<Expr> index = ConstantExpr::create(i - 1, offset->getWidth());
+    result = SelectExpr::create(EqExpr::create(offset, index), read8(i - 1),
+                                result);
+  }
+  return result;
+}
+
 ref<Expr> ObjectState::read8(ref<Expr> offset) const {
   assert(!isa<ConstantExpr>(offset) && "constant offset passed to symbolic read8");
+  if (isIteEncodable())
+    return readIte(offset);
+
   unsigned base, size;
   fastRangeCheckOffset(offset, &base, &size);
   flushRangeForRead(base, size);
@@ -384,13 +488,17 @@ ref<Expr> ObjectState::read8(ref<Expr> offset) const {
                       size,
                       allocInfo.c_str());
   }
-  
-  return ReadExpr::create(getUpdates(), ZExtExpr::create(offset, Expr::Int32));
+
+  compactUpdates();
+  const UpdateList &ul = getUpdates();
+  ++stats::updateListReads;
+  stats::updateListDepth += ul.getSize();
+  return ReadExpr::create(ul, ZExtExpr::create(offset, Expr::Int32));
 }
 
 void ObjectState::write8(unsigned offset, uint8_t value) {
   //assert(read_only == false && "writing to read-only object!");
-  concreteStore[offset] = value;
+  concreteStore.set(offset, value);
   setKnownSymbolic(offset, 0);
 
   markByteConcrete(offset);
@@ -424,6 +532,7 @@ void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
   }
   
   updates.extend(ZExtExpr::create(offset, Expr::Int32), value);
+  compactUpdates();
 }
 
 /***/
@@ -460,9 +569,24 @@ ref<Expr> ObjectState::read(unsigned offset, Expr::Width width) const {
   if (width == Expr::Bool)
     return ExtractExpr::create(read8(offset), 0, Expr::Bool);
 
-  // Otherwise, follow the slow general case.
   unsigned NumBytes = width / 8;
   assert(width == NumBytes * 8 && "Invalid width for read size!");
+
+  // Assemble concrete values directly instead of concatenating their bytes.
+  if (width <= Expr::Int64) {
+    uint64_t value = 0;
+    unsigned i = 0;
+    for (; i != NumBytes; ++i) {
+      unsigned idx = Context::get().isLittleEndian() ? i : (NumBytes - i - 1);
+      if (!isByteConcrete(offset + idx))
+        break;
+      value |= uint64_t(concreteStore[offset + idx]) << (8 * i);
+    }
+    if (i == NumBytes)
+      return ConstantExpr::create(value, width);
+  }
+
+  // Otherwise, follow the slow general case.
   ref<Expr> Res(0);
   for (unsigned i = 0; i != NumBytes; ++i) {
     unsigned idx = Context::get().isLittleEndian() ? i : (NumBytes - i - 1);
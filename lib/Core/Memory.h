@@ -11,8 +11,10 @@
 #define KLEE_MEMORY_H
 
 #include "Context.h"
+#include "MemoryPool.h"
 #include "TimingSolver.h"
 
+#include "klee/ADT/PagedArray.h"
 #include "klee/Expr/Expr.h"
 
 #include "llvm/ADT/StringExtras.h"
@@ -27,7 +29,6 @@ namespace llvm {
 namespace klee {
 
 class ArrayCache;
-class BitArray;
 class ExecutionState;
 class MemoryManager;
 class Solver;
@@ -50,6 +51,12 @@ public:
 
   /// size in bytes
   unsigned size;
+
+  /// The size of an object allocated with a symbolic size (at pointer
+  /// width), null otherwise. \ref size is the capacity of such an object,
+  /// which the symbolic size is constrained not to exceed.
+  ref<Expr> symbolicSize;
+
   mutable std::string name;
 
   bool isLocal;
@@ -105,6 +112,11 @@ public:
 
   ~MemoryObject();
 
+  static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+  static void operator delete(void *p, size_t size) {
+    MemoryPool::deallocate(p, size);
+  }
+
   /// Get an identifying string for this allocation.
   void getAllocInfo(std::string &result) const;
 
@@ -129,6 +141,8 @@ public:
   }
 
   ref<Expr> getBoundsCheckOffset(ref<Expr> offset) const {
+    if (!symbolicSize.isNull())
+      return UltExpr::create(offset, symbolicSize);
     if (size==0) {
       return EqExpr::create(offset, 
                             ConstantExpr::alloc(0, Context::get().getPointerWidth()));
@@ -137,6 +151,13 @@ public:
     }
   }
   ref<Expr> getBoundsCheckOffset(ref<Expr> offset, unsigned bytes) const {
+    if (!symbolicSize.isNull()) {
+      ref<Expr> count =
+          ConstantExpr::alloc(bytes, Context::get().getPointerWidth());
+      return AndExpr::create(
+          UleExpr::create(count, symbolicSize),
+          UleExpr::create(offset, SubExpr::create(symbolicSize, count)));
+    }
     if (bytes<=size) {
       return UltExpr::create(offset, 
                              ConstantExpr::alloc(size - bytes + 1, 
@@ -167,8 +188,20 @@ public:
 };
 
 class ObjectState {
+public:
+  // The pages of the contents are allocated from the MemoryPool.
+  typedef PagedArray<uint8_t, 4096, PoolAllocator<uint8_t>> ConcreteStore;
+  typedef PagedPackedArray<2, 4096, PoolAllocator<uint32_t>> ByteStates;
+  // Small pages, so only the ranges that hold symbolic bytes are allocated.
+  typedef PagedArray<ref<Expr>, 256, PoolAllocator<ref<Expr>>> SymbolicStore;
+
+#ifdef KLEE_UNITTEST
+public:
+#else
 private:
+#endif
   friend class AddressSpace;
+  friend class StateSerializer;
   friend class ref<ObjectState>;
 
   unsigned copyOnWriteOwner; // exclusively for AddressSpace
@@ -178,19 +211,27 @@ private:
 
   ref<const MemoryObject> object;
 
-  uint8_t *concreteStore;
+  // The contents are stored in pages shared with the copies of this object
+  // state, so a write after a fork only copies the pages it touches.
 
-  // XXX cleanup name of flushMask (its backwards or something)
-  BitArray *concreteMask;
+  // mutable because flushToConcreteStore writes to it
+  mutable ConcreteStore concreteStore;
+
+  /// Flags of the state of a byte. A byte without flags is concrete and
+  /// not flushed, as are all bytes of an object without byteStates.
+  enum ByteState { SymbolicByte = 1, FlushedByte = 2 };
 
   // mutable because may need flushed during read of const
-  mutable BitArray *flushMask;
+  mutable ByteStates *byteStates;
 
-  ref<Expr> *knownSymbolics;
+  SymbolicStore *knownSymbolics;
 
   // mutable because we may need flush during read of const
   mutable UpdateList updates;
 
+  /// Depth of the update list at which it is compacted next.
+  mutable unsigned nextCompaction;
+
 public:
   unsigned size;
 
@@ -209,6 +250,11 @@ public:
   ObjectState(const ObjectState &os);
   ~ObjectState();
 
+  static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+  static void operator delete(void *p, size_t size) {
+    MemoryPool::deallocate(p, size);
+  }
+
   const MemoryObject *getObject() const { return object.get(); }
 
   void setReadOnly(bool ro) { readOnly = ro; }
@@ -232,6 +278,9 @@ public:
   void write64(unsigned offset, uint64_t value);
   void print() const;
 
+  /// Whether none of the bytes of this object is symbolic.
+  bool isConcrete() const;
+
   /*
     Looks at all the symbolic bytes of this object, gets a value for them
     from the solver and puts them in the concreteStore.
@@ -239,15 +288,28 @@ public:
   void flushToConcreteStore(TimingSolver *solver,
                             const ExecutionState &state) const;
 
+#ifdef KLEE_UNITTEST
+public:
+#else
 private:
+#endif
   const UpdateList &getUpdates() const;
 
+  /// Compacts the update list once it has grown to nextCompaction.
+  void compactUpdates() const;
+
   void makeConcrete();
 
   void makeSymbolic();
 
   ref<Expr> read8(ref<Expr> offset) const;
   void write8(unsigned offset, ref<Expr> value);
+
+  /// Whether reads at symbolic offsets are encoded by readIte.
+  bool isIteEncodable() const;
+  /// Reads the byte at a symbolic offset as if-then-else chain over all
+  /// bytes, which keeps the query free of array theory.
+  ref<Expr> readIte(ref<Expr> offset) const;
   void write8(ref<Expr> offset, ref<Expr> value);
 
   void fastRangeCheckOffset(ref<Expr> offset, unsigned *base_r, 
@@ -261,7 +323,7 @@ private:
 
   void markByteConcrete(unsigned offset);
   void markByteSymbolic(unsigned offset);
-  void markByteFlushed(unsigned offset);
+  void markByteFlushed(unsigned offset) const;
   void markByteUnflushed(unsigned offset);
   void setKnownSymbolic(unsigned offset, Expr *value);
 
@@ -11,6 +11,7 @@
 
 #include "CoreStats.h"
 #include "Memory.h"
+#include "MemoryPool.h"
 
 #include "klee/Expr/Expr.h"
 #include "klee/Support/ErrorHandling.h"
@@ -20,6 +21,7 @@
 
 #include <inttypes.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 using namespace klee;
 
@@ -56,6 +58,47 @@ llvm::cl::opt<unsigned long long> DeterministicStartAddress(
     llvm::cl::desc("Start address for deterministic allocation. Has to be page "
                    "aligned (default=0x7ff30000000)"),
     llvm::cl::init(0x7ff30000000), llvm::cl::cat(MemoryCat));
+
+llvm::cl::opt<unsigned> DeterministicQuarantine(
+    "allocate-determ-quarantine",
+    llvm::cl::desc("Number of freed objects whose memory is not reused yet "
+                   "during deterministic allocation (default=1024)"),
+    llvm::cl::init(1024), llvm::cl::cat(MemoryCat));
+
+llvm::cl::opt<bool> DeterministicGuardPages(
+    "allocate-determ-guard-pages",
+    llvm::cl::desc("Follow every object of at least a page with an "
+                   "inaccessible guard page instead of a redzone during "
+                   "deterministic allocation (default=false)"),
+    llvm::cl::init(false), llvm::cl::cat(MemoryCat));
+
+llvm::cl::opt<unsigned> SymbolicSizeCapacity(
+    "symbolic-size-capacity",
+    llvm::cl::desc("Keep the size of allocations with a symbolic size of at "
+                   "most this many bytes symbolic, only larger sizes are "
+                   "concretized (0=always concretize, default=4096)"),
+    llvm::cl::init(4096), llvm::cl::cat(MemoryCat));
+
+uint64_t getPageSize() {
+  static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+  return pageSize;
+}
+
+/// Size of the slot of the deterministic space an object of the given size
+/// is placed in. Slots of the same size are interchangeable: small objects
+/// get the next power of two, objects of at least a page whole pages.
+uint64_t getSlotSize(uint64_t size) {
+  // 0-sized allocations are handled as 1-byte allocations, so they are
+  // placed between their own red zones
+  size = std::max(size, (uint64_t)1);
+  if (size >= getPageSize())
+    return (size + getPageSize() - 1) / getPageSize() * getPageSize();
+  return std::max((uint64_t)16, llvm::NextPowerOf2(size - 1));
+}
+
+bool hasGuardPage(uint64_t slotSize) {
+  return DeterministicGuardPages && slotSize >= getPageSize();
+}
 } // namespace
 
 /***/
@@ -94,6 +137,9 @@ MemoryManager::~MemoryManager() {
 
   if (DeterministicAllocation)
     munmap(deterministicSpace, spaceSize);
+
+  // object states of terminated states are gone by now, their slabs can go
+  MemoryPool::trim();
 }
 
 MemoryObject *MemoryManager::allocate(uint64_t size, bool isLocal,
@@ -116,24 +162,7 @@ MemoryObject *MemoryManager::allocate(uint64_t size, bool isLocal,
 
   uint64_t address = 0;
   if (DeterministicAllocation) {
-#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 9)
-    address = llvm::alignTo((uint64_t)nextFreeSlot + alignment - 1, alignment);
-#else
-    address = llvm::RoundUpToAlignment((uint64_t)nextFreeSlot + alignment - 1,
-                                       alignment);
-#endif
-
-    // Handle the case of 0-sized allocations as 1-byte allocations.
-    // This way, we make sure we have this allocation between its own red zones
-    size_t alloc_size = std::max(size, (uint64_t)1);
-    if ((char *)address + alloc_size < deterministicSpace + spaceSize) {
-      nextFreeSlot = (char *)address + alloc_size + RedzoneSize;
-    } else {
-      klee_warning_once(0, "Couldn't allocate %" PRIu64
-                           " bytes. Not enough deterministic space left.",
-                        size);
-      address = 0;
-    }
+    address = allocateDeterministic(size, alignment);
   } else {
     // Use malloc for the standard case
     if (alignment <= 8)
@@ -175,16 +204,93 @@ MemoryObject *MemoryManager::allocateFixed(uint64_t address, uint64_t size,
   return res;
 }
 
+MemoryObject *MemoryManager::allocateSymbolicSize(ref<Expr> size,
+                                                  bool isLocal,
+                                                  const llvm::Value *allocSite,
+                                                  size_t alignment) {
+  assert(size->getWidth() == Context::get().getPointerWidth() &&
+         "symbolic size must have pointer width");
+  MemoryObject *mo = allocate(SymbolicSizeCapacity, isLocal,
+                              /*isGlobal=*/false, allocSite, alignment);
+  if (mo)
+    mo->symbolicSize = size;
+  return mo;
+}
+
+uint64_t MemoryManager::getSymbolicSizeCapacity() {
+  return SymbolicSizeCapacity;
+}
+
 void MemoryManager::deallocate(const MemoryObject *mo) { assert(0); }
 
 void MemoryManager::markFreed(MemoryObject *mo) {
   if (objects.find(mo) != objects.end()) {
-    if (!mo->isFixed && !DeterministicAllocation)
-      free((void *)mo->address);
+    if (!mo->isFixed) {
+      if (DeterministicAllocation)
+        freeDeterministic(mo);
+      else
+        free((void *)mo->address);
+    }
     objects.erase(mo);
   }
 }
 
+uint64_t MemoryManager::allocateDeterministic(uint64_t size,
+                                              size_t alignment) {
+  uint64_t slotSize = getSlotSize(size);
+
+  // reuse the slot that left the quarantine first
+  auto slots = freeSlots.find(slotSize);
+  if (slots != freeSlots.end()) {
+    std::deque<uint64_t> &addresses = slots->second;
+    for (auto it = addresses.begin(), ie = addresses.end(); it != ie; ++it) {
+      if (*it % alignment == 0) {
+        uint64_t address = *it;
+        addresses.erase(it);
+        return address;
+      }
+    }
+  }
+
+  bool guardPage = hasGuardPage(slotSize);
+  if (guardPage)
+    alignment = std::max<uint64_t>(alignment, getPageSize());
+  else
+    alignment = std::max<uint64_t>(alignment, 16);
+
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 9)
+  uint64_t address = llvm::alignTo((uint64_t)nextFreeSlot, alignment);
+#else
+  uint64_t address =
+      llvm::RoundUpToAlignment((uint64_t)nextFreeSlot, alignment);
+#endif
+
+  uint64_t redzone = guardPage ? getPageSize() : RedzoneSize;
+  if (address + slotSize + redzone >
+      (uint64_t)(deterministicSpace + spaceSize)) {
+    klee_warning_once(0, "Couldn't allocate %" PRIu64
+                         " bytes. Not enough deterministic space left.",
+                      size);
+    return 0;
+  }
+
+  if (guardPage &&
+      mprotect((void *)(address + slotSize), getPageSize(), PROT_NONE) != 0)
+    klee_warning_once(0, "Couldn't protect guard page of deterministic "
+                         "allocation");
+
+  nextFreeSlot = (char *)(address + slotSize + redzone);
+  return address;
+}
+
+void MemoryManager::freeDeterministic(const MemoryObject *mo) {
+  quarantine.emplace_back(getSlotSize(mo->size), mo->address);
+  while (quarantine.size() > DeterministicQuarantine) {
+    freeSlots[quarantine.front().first].push_back(quarantine.front().second);
+    quarantine.pop_front();
+  }
+}
+
 size_t MemoryManager::getUsedDeterministicSize() {
   return nextFreeSlot - deterministicSpace;
 }
@@ -11,6 +11,8 @@
 #define KLEE_MEMORYMANAGER_H
 
 #include <cstddef>
+#include <deque>
+#include <map>
 #include <set>
 #include <cstdint>
 
@@ -19,8 +21,10 @@ class Value;
 }
 
 namespace klee {
+class Expr;
 class MemoryObject;
 class ArrayCache;
+template <class T> class ref;
 
 class MemoryManager {
 private:
@@ -32,6 +36,18 @@ private:
   char *nextFreeSlot;
   size_t spaceSize;
 
+  /// Slots of the deterministic space that can be reused, by slot size and
+  /// in the order they left the quarantine.
+  std::map<uint64_t, std::deque<uint64_t>> freeSlots;
+
+  /// Freed slots of the deterministic space as (slot size, address), oldest
+  /// first. They are only reused once they leave the quarantine, so
+  /// dangling pointers do not immediately point to new objects.
+  std::deque<std::pair<uint64_t, uint64_t>> quarantine;
+
+  uint64_t allocateDeterministic(uint64_t size, size_t alignment);
+  void freeDeterministic(const MemoryObject *mo);
+
 public:
   MemoryManager(ArrayCache *arrayCache);
   ~MemoryManager();
@@ -44,6 +60,17 @@ public:
                          const llvm::Value *allocSite, size_t alignment);
   MemoryObject *allocateFixed(uint64_t address, uint64_t size,
                               const llvm::Value *allocSite);
+
+  /// Returns a memory object of size `size`, which has to be a symbolic
+  /// expression of pointer width the caller constrains to be at most
+  /// getSymbolicSizeCapacity(). The object reserves that capacity.
+  MemoryObject *allocateSymbolicSize(ref<Expr> size, bool isLocal,
+                                     const llvm::Value *allocSite,
+                                     size_t alignment);
+
+  /// Returns the capacity of objects with a symbolic size, 0 if symbolic
+  /// sizes are to be concretized instead.
+  static uint64_t getSymbolicSizeCapacity();
   void deallocate(const MemoryObject *mo);
   void markFreed(MemoryObject *mo);
   ArrayCache *getArrayCache() const { return arrayCache; }
@@ -0,0 +1,313 @@
+//===-- MemoryPool.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MemoryPool.h"
+
+#include "CoreStats.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+using namespace klee;
+
+namespace {
+
+/// Slabs are aligned to their size, so the slab of a block is found by
+/// masking its address. Twice the slab size must stay below glibc's mmap
+/// threshold, otherwise every aligned slab is mapped separately and counts
+/// twice in the malloc usage.
+const std::size_t SlabSize = 32 * 1024;
+
+/// Sizes up to 256 bytes are rounded to multiples of 16, larger ones to
+/// powers of two up to MemoryPool::MaxBlockSize.
+const unsigned NumSmallClasses = 16;
+const unsigned NumSizeClasses = NumSmallClasses + 4;
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct ThreadPool;
+
+/// Header at the start of every slab, the blocks follow it.
+struct Slab {
+  ThreadPool *pool;
+  unsigned sizeClass;
+  std::size_t numBlocks;
+  std::size_t numFree;
+  FreeBlock *freeList;
+  /// neighbours in the list of slabs of the class with free blocks
+  Slab *prev;
+  Slab *next;
+};
+
+const std::size_t SlabHeaderSize = (sizeof(Slab) + 63) / 64 * 64;
+
+/// The size classes of one thread. Only the owning thread touches the slabs
+/// and needs no lock for it. Other threads hand the blocks they release to
+/// the owner through the remote list. Once the thread exits, the pool is
+/// orphaned and everybody accesses it under the lock until its last slab is
+/// gone.
+struct ThreadPool {
+  /// per size class, the slabs with free blocks, allocation takes from the
+  /// first one
+  Slab *partial[NumSizeClasses] = {};
+  std::size_t numSlabs = 0;
+
+  std::mutex lock;
+  /// guarded by lock
+  FreeBlock *remoteFrees = nullptr;
+  bool orphaned = false;
+};
+
+unsigned getSizeClass(std::size_t size) {
+  if (size <= 16 * NumSmallClasses)
+    return size == 0 ? 0 : (size - 1) / 16;
+  unsigned sizeClass = NumSmallClasses;
+  for (std::size_t blockSize = 512; blockSize < size; blockSize *= 2)
+    ++sizeClass;
+  return sizeClass;
+}
+
+std::size_t getBlockSize(unsigned sizeClass) {
+  if (sizeClass < NumSmallClasses)
+    return 16 * (sizeClass + 1);
+  return std::size_t(512) << (sizeClass - NumSmallClasses);
+}
+
+Slab *getSlab(void *block) {
+  return reinterpret_cast<Slab *>(reinterpret_cast<std::uintptr_t>(block) &
+                                  ~std::uintptr_t(SlabSize - 1));
+}
+
+void link(ThreadPool &pool, Slab *slab) {
+  Slab *&head = pool.partial[slab->sizeClass];
+  slab->prev = nullptr;
+  slab->next = head;
+  if (head)
+    head->prev = slab;
+  head = slab;
+}
+
+void unlink(ThreadPool &pool, Slab *slab) {
+  if (slab->prev)
+    slab->prev->next = slab->next;
+  else
+    pool.partial[slab->sizeClass] = slab->next;
+  if (slab->next)
+    slab->next->prev = slab->prev;
+}
+
+Slab *createSlab(ThreadPool &pool, unsigned sizeClass) {
+  void *memory;
+  if (posix_memalign(&memory, SlabSize, SlabSize) != 0)
+    throw std::bad_alloc();
+
+  auto *slab = static_cast<Slab *>(memory);
+  std::size_t blockSize = getBlockSize(sizeClass);
+  slab->pool = &pool;
+  slab->sizeClass = sizeClass;
+  slab->numBlocks = (SlabSize - SlabHeaderSize) / blockSize;
+  slab->numFree = slab->numBlocks;
+  slab->freeList = nullptr;
+  char *blocks = static_cast<char *>(memory) + SlabHeaderSize;
+  for (std::size_t i = slab->numBlocks; i != 0; --i) {
+    auto *block = reinterpret_cast<FreeBlock *>(blocks + (i - 1) * blockSize);
+    block->next = slab->freeList;
+    slab->freeList = block;
+  }
+
+  link(pool, slab);
+  ++pool.numSlabs;
+  return slab;
+}
+
+void destroySlab(ThreadPool &pool, Slab *slab) {
+  unlink(pool, slab);
+  --pool.numSlabs;
+  std::free(slab);
+}
+
+void *allocateFrom(ThreadPool &pool, unsigned sizeClass) {
+  Slab *slab = pool.partial[sizeClass];
+  if (!slab)
+    slab = createSlab(pool, sizeClass);
+
+  FreeBlock *block = slab->freeList;
+  slab->freeList = block->next;
+  if (--slab->numFree == 0)
+    unlink(pool, slab);
+  return block;
+}
+
+/// Returns the block to its slab and the slab to the global allocator once
+/// it is completely free. One free slab per class is kept while the pool is
+/// in use, so a class that goes back and forth between zero and one block
+/// does not allocate a slab every time.
+void releaseTo(ThreadPool &pool, Slab *slab, void *p) {
+  auto *block = static_cast<FreeBlock *>(p);
+  block->next = slab->freeList;
+  slab->freeList = block;
+  if (slab->numFree++ == 0)
+    link(pool, slab);
+
+  if (slab->numFree == slab->numBlocks &&
+      (pool.orphaned || slab->prev || slab->next))
+    destroySlab(pool, slab);
+}
+
+/// Releases the blocks other threads returned to the pool, call with the
+/// lock held if the pool is orphaned.
+void releaseRemoteFrees(ThreadPool &pool, FreeBlock *blocks) {
+  while (blocks) {
+    FreeBlock *next = blocks->next;
+    releaseTo(pool, getSlab(blocks), blocks);
+    blocks = next;
+  }
+}
+
+void trimPool(ThreadPool &pool) {
+  for (unsigned i = 0; i < NumSizeClasses; ++i) {
+    for (Slab *slab = pool.partial[i]; slab;) {
+      Slab *next = slab->next;
+      if (slab->numFree == slab->numBlocks)
+        destroySlab(pool, slab);
+      slab = next;
+    }
+  }
+}
+
+void orphan(ThreadPool *pool) {
+  bool empty;
+  {
+    std::lock_guard<std::mutex> guard(pool->lock);
+    pool->orphaned = true;
+    releaseRemoteFrees(*pool, pool->remoteFrees);
+    pool->remoteFrees = nullptr;
+    trimPool(*pool);
+    empty = pool->numSlabs == 0;
+  }
+  if (empty)
+    delete pool;
+}
+
+thread_local ThreadPool *localPool = nullptr;
+thread_local bool localPoolDestroyed = false;
+
+/// Orphans the pool of the thread when the thread exits.
+struct LocalPoolOwner {
+  ~LocalPoolOwner() {
+    localPoolDestroyed = true;
+    if (localPool)
+      orphan(localPool);
+    localPool = nullptr;
+  }
+};
+
+/// \return the pool of the calling thread, or null once the thread's thread
+/// local storage is being destroyed.
+ThreadPool *getLocalPool() {
+  if (!localPool && !localPoolDestroyed) {
+    static thread_local LocalPoolOwner owner;
+    (void)owner;
+    localPool = new ThreadPool();
+  }
+  return localPool;
+}
+
+/// Serves allocations made while a thread's storage is destroyed, e.g.
+/// during static destruction. It is orphaned from the start.
+ThreadPool *getSharedPool() {
+  static ThreadPool *pool = [] {
+    auto *pool = new ThreadPool();
+    pool->orphaned = true;
+    return pool;
+  }();
+  return pool;
+}
+
+} // namespace
+
+void *MemoryPool::allocate(std::size_t size) {
+  if (size > MaxBlockSize)
+    return ::operator new(size);
+
+  unsigned sizeClass = getSizeClass(size);
+  if (ThreadPool *pool = getLocalPool()) {
+    if (!pool->partial[sizeClass]) {
+      // blocks other threads released may make a new slab unnecessary
+      FreeBlock *remoteFrees;
+      {
+        std::lock_guard<std::mutex> guard(pool->lock);
+        remoteFrees = pool->remoteFrees;
+        pool->remoteFrees = nullptr;
+      }
+      releaseRemoteFrees(*pool, remoteFrees);
+      if (!pool->partial[sizeClass])
+        ++stats::poolSlabs;
+    }
+    ++stats::poolAllocations;
+    return allocateFrom(*pool, sizeClass);
+  }
+
+  ThreadPool *pool = getSharedPool();
+  std::lock_guard<std::mutex> guard(pool->lock);
+  return allocateFrom(*pool, sizeClass);
+}
+
+void MemoryPool::deallocate(void *p, std::size_t size) {
+  if (!p)
+    return;
+  if (size > MaxBlockSize) {
+    ::operator delete(p);
+    return;
+  }
+
+  Slab *slab = getSlab(p);
+  assert(slab->sizeClass == getSizeClass(size) &&
+         "block was not allocated from the pool");
+  ThreadPool *pool = slab->pool;
+  if (pool == localPool) {
+    releaseTo(*pool, slab, p);
+    return;
+  }
+
+  bool empty;
+  {
+    std::lock_guard<std::mutex> guard(pool->lock);
+    if (!pool->orphaned) {
+      auto *block = static_cast<FreeBlock *>(p);
+      block->next = pool->remoteFrees;
+      pool->remoteFrees = block;
+      return;
+    }
+    releaseTo(*pool, slab, p);
+    empty = pool->numSlabs == 0 && pool != getSharedPool();
+  }
+  if (empty)
+    delete pool;
+}
+
+void MemoryPool::trim() {
+  ThreadPool *pool = getLocalPool();
+  if (!pool)
+    return;
+
+  FreeBlock *remoteFrees;
+  {
+    std::lock_guard<std::mutex> guard(pool->lock);
+    remoteFrees = pool->remoteFrees;
+    pool->remoteFrees = nullptr;
+  }
+  releaseRemoteFrees(*pool, remoteFrees);
+  trimPool(*pool);
+}
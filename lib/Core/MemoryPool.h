@@ -0,0 +1,65 @@
+//===-- MemoryPool.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_MEMORYPOOL_H
+#define KLEE_MEMORYPOOL_H
+
+#include <cstddef>
+
+namespace klee {
+
+/// Slab allocator for the many small, short-lived structures that model
+/// the memory of the program under test: memory objects, object states and
+/// their content pages. Requests are rounded up to a size class and served
+/// from a slab of the class. Requests larger than the largest class go to
+/// the global allocator.
+///
+/// Every thread has its own slabs, so neither allocating nor releasing a
+/// block takes a lock. Blocks released by another thread are handed back to
+/// the owning thread, which picks them up before it needs a new slab. A slab
+/// goes back to the global allocator as soon as all of its blocks are free,
+/// only the last one of a class is kept until trim.
+class MemoryPool {
+public:
+  /// The largest request served from a size class.
+  static const std::size_t MaxBlockSize = 4096;
+
+  static void *allocate(std::size_t size);
+  static void deallocate(void *p, std::size_t size);
+
+  /// Releases the calling thread's slabs without blocks in use.
+  static void trim();
+};
+
+/// Standard allocator interface to the MemoryPool.
+template <class T> class PoolAllocator {
+public:
+  typedef T value_type;
+
+  PoolAllocator() = default;
+  template <class U> PoolAllocator(const PoolAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(MemoryPool::allocate(n * sizeof(T)));
+  }
+  void deallocate(T *p, std::size_t n) {
+    MemoryPool::deallocate(p, n * sizeof(T));
+  }
+
+  template <class U> bool operator==(const PoolAllocator<U> &) const {
+    return true;
+  }
+  template <class U> bool operator!=(const PoolAllocator<U> &) const {
+    return false;
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_MEMORYPOOL_H */
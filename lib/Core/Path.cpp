@@ -45,10 +45,24 @@ namespace klee {
         return symbolicValues;
     }
 
+    void Path::releaseResults() {
+        // drop the expressions once they have been written out, the block list and timings stay valid
+        constraints = ConstraintSet();
+        symbolicValues.clear();
+    }
+
     std::string Path::getPathRepr() {
         return repr;
     }
 
+    void Path::setSymexTime(time::Span span) {
+        symexTime = span;
+    }
+
+    time::Span Path::getSymexTime() {
+        return symexTime;
+    }
+
     llvm::BasicBlock *Path::front() {
         return blocks.front();
     }
@@ -77,6 +91,7 @@ namespace klee {
         result->symbolicValues = VariableExpressionMap(this->symbolicValues);
 
         result->repr = std::string(this->repr);
+        result->symexTime = this->symexTime;
     }
 
 }
\ No newline at end of file
@@ -232,6 +232,10 @@ void WeightedRandomSearcher::update(ExecutionState *current,
     states->remove(state);
 }
 
+bool WeightedRandomSearcher::updatesCurrent() {
+  return updateWeights;
+}
+
 bool WeightedRandomSearcher::empty() {
   return states->empty();
 }
@@ -397,6 +401,10 @@ void MergingSearcher::update(ExecutionState *current,
   }
 }
 
+bool MergingSearcher::updatesCurrent() {
+  return baseSearcher->updatesCurrent();
+}
+
 bool MergingSearcher::empty() {
   return baseSearcher->empty();
 }
@@ -447,6 +455,10 @@ void BatchingSearcher::update(ExecutionState *current,
   baseSearcher->update(current, addedStates, removedStates);
 }
 
+bool BatchingSearcher::updatesCurrent() {
+  return baseSearcher->updatesCurrent();
+}
+
 bool BatchingSearcher::empty() {
   return baseSearcher->empty();
 }
@@ -510,6 +522,11 @@ void IterativeDeepeningTimeSearcher::update(ExecutionState *current,
   }
 }
 
+bool IterativeDeepeningTimeSearcher::updatesCurrent() {
+  // the time budget of the current state is checked on every update
+  return true;
+}
+
 bool IterativeDeepeningTimeSearcher::empty() {
   return baseSearcher->empty() && pausedStates.empty();
 }
@@ -542,6 +559,13 @@ void InterleavedSearcher::update(ExecutionState *current,
     searcher->update(current, addedStates, removedStates);
 }
 
+bool InterleavedSearcher::updatesCurrent() {
+  for (auto &searcher : searchers)
+    if (searcher->updatesCurrent())
+      return true;
+  return false;
+}
+
 bool InterleavedSearcher::empty() {
   return searchers[0]->empty();
 }
@@ -53,6 +53,11 @@ namespace klee {
                         const std::vector<ExecutionState *> &addedStates,
                         const std::vector<ExecutionState *> &removedStates) = 0;
 
+    /// \return True if `update` has to be called for the current state after
+    /// every instruction, False if it only needs to be called when states are
+    /// added or removed.
+    virtual bool updatesCurrent() { return false; }
+
     /// \return True if no state left for exploration, False otherwise
     virtual bool empty() = 0;
 
@@ -152,6 +157,7 @@ namespace klee {
     void update(ExecutionState *current,
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates) override;
+    bool updatesCurrent() override;
     bool empty() override;
     void printName(llvm::raw_ostream &os) override;
   };
@@ -233,6 +239,7 @@ namespace klee {
     void update(ExecutionState *current,
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates) override;
+    bool updatesCurrent() override;
 
     bool empty() override;
     void printName(llvm::raw_ostream &os) override;
@@ -261,6 +268,7 @@ namespace klee {
     void update(ExecutionState *current,
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates) override;
+    bool updatesCurrent() override;
     bool empty() override;
     void printName(llvm::raw_ostream &os) override;
   };
@@ -285,6 +293,7 @@ namespace klee {
     void update(ExecutionState *current,
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates) override;
+    bool updatesCurrent() override;
     bool empty() override;
     void printName(llvm::raw_ostream &os) override;
   };
@@ -305,6 +314,7 @@ namespace klee {
     void update(ExecutionState *current,
                 const std::vector<ExecutionState *> &addedStates,
                 const std::vector<ExecutionState *> &removedStates) override;
+    bool updatesCurrent() override;
     bool empty() override;
     void printName(llvm::raw_ostream &os) override;
   };
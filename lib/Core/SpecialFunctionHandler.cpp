@@ -659,11 +659,16 @@ void SpecialFunctionHandler::handleGetObjSize(ExecutionState &state,
   executor.resolveExact(state, arguments[0], rl, "klee_get_obj_size");
   for (Executor::ExactResolutionList::iterator it = rl.begin(), 
          ie = rl.end(); it != ie; ++it) {
-    executor.bindLocal(
-        target, *it->second,
-        ConstantExpr::create(it->first.first->size,
-                             executor.kmodule->targetData->getTypeSizeInBits(
-                                 target->inst->getType())));
+    const MemoryObject *mo = it->first.first;
+    Expr::Width width = executor.kmodule->targetData->getTypeSizeInBits(
+        target->inst->getType());
+    if (!mo->symbolicSize.isNull()) {
+      executor.bindLocal(target, *it->second,
+                         ZExtExpr::create(mo->symbolicSize, width));
+    } else {
+      executor.bindLocal(target, *it->second,
+                         ConstantExpr::create(mo->size, width));
+    }
   }
 }
 
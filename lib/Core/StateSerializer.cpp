@@ -0,0 +1,460 @@
+//===-- StateSerializer.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "StateSerializer.h"
+
+#include "AddressSpace.h"
+#include "ExecutionState.h"
+#include "Memory.h"
+
+#include "klee/ADT/PagedArray.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Module/Cell.h"
+#include "klee/Module/KModule.h"
+#include "klee/Support/ErrorHandling.h"
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace klee;
+
+namespace {
+
+/// Writes numbers as LEB128 and expressions and update lists as DAGs. A
+/// reference is 0 for null, 1 if the definition follows inline and n + 2 for
+/// the n-th definition written before.
+class SpillWriter {
+  std::ostream &out;
+  std::unordered_map<const Expr *, uint64_t> exprIds;
+  std::unordered_map<const UpdateNode *, uint64_t> nodeIds;
+
+public:
+  explicit SpillWriter(std::ostream &_out) : out(_out) {}
+
+  void writeNumber(uint64_t value) {
+    do {
+      uint8_t byte = value & 0x7F;
+      value >>= 7;
+      if (value)
+        byte |= 0x80;
+      out.put(byte);
+    } while (value);
+  }
+
+  void writePointer(const void *pointer) {
+    writeNumber(reinterpret_cast<uintptr_t>(pointer));
+  }
+
+  void writeBytes(const ObjectState::ConcreteStore &bytes) {
+    std::vector<uint8_t> buffer(bytes.size());
+    bytes.copyTo(buffer.data());
+    out.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+  }
+
+  void writeByteStates(ObjectState::ByteStates *states, unsigned size) {
+    writeNumber(states != nullptr);
+    if (!states)
+      return;
+    for (unsigned i = 0; i < size; i += 4) {
+      uint8_t byte = 0;
+      for (unsigned j = 0; j < 4 && i + j < size; ++j)
+        byte |= states->get(i + j) << (2 * j);
+      out.put(byte);
+    }
+  }
+
+  void writeExpr(const ref<Expr> &e) {
+    if (e.isNull()) {
+      writeNumber(0);
+      return;
+    }
+    auto it = exprIds.find(e.get());
+    if (it != exprIds.end()) {
+      writeNumber(it->second + 2);
+      return;
+    }
+
+    writeNumber(1);
+    writeNumber(e->getKind());
+    switch (e->getKind()) {
+    case Expr::Constant: {
+      const llvm::APInt &value = cast<ConstantExpr>(e)->getAPValue();
+      writeNumber(value.getBitWidth());
+      for (unsigned i = 0; i < value.getNumWords(); ++i)
+        writeNumber(value.getRawData()[i]);
+      break;
+    }
+    case Expr::Read: {
+      const auto *re = cast<ReadExpr>(e);
+      writeUpdates(re->updates);
+      writeExpr(re->index);
+      break;
+    }
+    case Expr::Extract: {
+      const auto *ee = cast<ExtractExpr>(e);
+      writeNumber(ee->offset);
+      writeNumber(ee->width);
+      writeExpr(ee->expr);
+      break;
+    }
+    case Expr::ZExt:
+    case Expr::SExt: {
+      const auto *ce = cast<CastExpr>(e);
+      writeNumber(ce->width);
+      writeExpr(ce->src);
+      break;
+    }
+    default:
+      for (unsigned i = 0; i < e->getNumKids(); ++i)
+        writeExpr(e->getKid(i));
+    }
+
+    exprIds.emplace(e.get(), exprIds.size());
+  }
+
+  void writeUpdates(const UpdateList &updates) {
+    writePointer(updates.root);
+    writeNode(updates.head.get());
+  }
+
+private:
+  void writeNode(const UpdateNode *head) {
+    if (!head) {
+      writeNumber(0);
+      return;
+    }
+    auto it = nodeIds.find(head);
+    if (it != nodeIds.end()) {
+      writeNumber(it->second + 2);
+      return;
+    }
+
+    // update lists can be long, so the nodes not written yet are written as
+    // one sequence on top of the newest node that is already known
+    std::vector<const UpdateNode *> nodes;
+    const UpdateNode *base = head;
+    for (; base && !nodeIds.count(base); base = base->next.get())
+      nodes.push_back(base);
+
+    writeNumber(1);
+    writeNode(base);
+    writeNumber(nodes.size());
+    for (auto nodeIt = nodes.rbegin(); nodeIt != nodes.rend(); ++nodeIt) {
+      writeExpr((*nodeIt)->index);
+      writeExpr((*nodeIt)->value);
+      nodeIds.emplace(*nodeIt, nodeIds.size());
+    }
+  }
+};
+
+class SpillReader {
+  std::istream &in;
+  std::vector<ref<Expr>> exprs;
+  std::vector<ref<UpdateNode>> nodes;
+
+public:
+  explicit SpillReader(std::istream &_in) : in(_in) {}
+
+  uint64_t readNumber() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; in; shift += 7) {
+      uint8_t byte = in.get();
+      value |= uint64_t(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+    return value;
+  }
+
+  template <class T> T *readPointer() {
+    return reinterpret_cast<T *>(static_cast<uintptr_t>(readNumber()));
+  }
+
+  void readBytes(ObjectState::ConcreteStore &bytes) {
+    std::vector<uint8_t> buffer(bytes.size());
+    in.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+    bytes.assign(buffer.data());
+  }
+
+  ObjectState::ByteStates *readByteStates(unsigned size) {
+    if (!readNumber())
+      return nullptr;
+    auto *states = new ObjectState::ByteStates(size);
+    for (unsigned i = 0; i < size; i += 4) {
+      uint8_t byte = in.get();
+      for (unsigned j = 0; j < 4 && i + j < size; ++j)
+        states->set(i + j, (byte >> (2 * j)) & 3);
+    }
+    return states;
+  }
+
+  ref<Expr> readExpr() {
+    uint64_t reference = readNumber();
+    if (reference == 0)
+      return ref<Expr>();
+    if (reference != 1) {
+      assert(reference - 2 < exprs.size() && "invalid expression reference");
+      return exprs[reference - 2];
+    }
+
+    ref<Expr> result;
+    auto kind = static_cast<Expr::Kind>(readNumber());
+    switch (kind) {
+    case Expr::Constant: {
+      unsigned width = readNumber();
+      std::vector<uint64_t> words((width + 63) / 64);
+      for (auto &word : words)
+        word = readNumber();
+      result = ConstantExpr::alloc(llvm::APInt(width, words));
+      break;
+    }
+    case Expr::Read: {
+      UpdateList updates = readUpdates();
+      result = ReadExpr::create(updates, readExpr());
+      break;
+    }
+    case Expr::Extract: {
+      unsigned offset = readNumber();
+      Expr::Width width = readNumber();
+      result = ExtractExpr::create(readExpr(), offset, width);
+      break;
+    }
+    case Expr::ZExt:
+    case Expr::SExt: {
+      Expr::Width width = readNumber();
+      ref<Expr> src = readExpr();
+      result = kind == Expr::ZExt ? ZExtExpr::create(src, width)
+                                  : SExtExpr::create(src, width);
+      break;
+    }
+    case Expr::Not:
+      result = NotExpr::create(readExpr());
+      break;
+    case Expr::NotOptimized:
+      result = Expr::createFromKind(kind, {readExpr()});
+      break;
+    case Expr::Select: {
+      ref<Expr> cond = readExpr();
+      ref<Expr> trueExpr = readExpr();
+      ref<Expr> falseExpr = readExpr();
+      result = Expr::createFromKind(kind, {cond, trueExpr, falseExpr});
+      break;
+    }
+    default: {
+      ref<Expr> left = readExpr();
+      ref<Expr> right = readExpr();
+      result = Expr::createFromKind(kind, {left, right});
+    }
+    }
+
+    exprs.push_back(result);
+    return result;
+  }
+
+  UpdateList readUpdates() {
+    const auto *root = readPointer<const Array>();
+    return UpdateList(root, readNode());
+  }
+
+private:
+  ref<UpdateNode> readNode() {
+    uint64_t reference = readNumber();
+    if (reference == 0)
+      return ref<UpdateNode>();
+    if (reference != 1) {
+      assert(reference - 2 < nodes.size() && "invalid update node reference");
+      return nodes[reference - 2];
+    }
+
+    ref<UpdateNode> head = readNode();
+    for (uint64_t count = readNumber(); count != 0 && in; --count) {
+      ref<Expr> index = readExpr();
+      ref<Expr> value = readExpr();
+      head = new UpdateNode(head, index, value);
+      nodes.push_back(head);
+    }
+    return head;
+  }
+};
+
+} // namespace
+
+StateSerializer::StateSerializer(std::string _directory)
+    : directory(std::move(_directory)) {
+  mkdir(directory.c_str(), 0775);
+}
+
+StateSerializer::~StateSerializer() {
+  for (const auto &spilled : spilledStates)
+    std::remove(spilled.second.fileName.c_str());
+  rmdir(directory.c_str());
+}
+
+bool StateSerializer::spill(ExecutionState &state) {
+  SpilledState spilled;
+  spilled.fileName =
+      directory + "/state" + std::to_string(state.getID()) + ".spill";
+
+  std::ofstream out(spilled.fileName, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    klee_warning("unable to write spilled state to %s",
+                 spilled.fileName.c_str());
+    return false;
+  }
+  SpillWriter writer(out);
+
+  // registers and their segments, the ones still shared with the frame of
+  // another state are skipped
+  for (const StackFrame &sf : state.stack) {
+    bool spillLocals = sf.locals.use_count() == 1;
+    writer.writeNumber(spillLocals);
+    if (spillLocals) {
+      for (unsigned i = 0; i < sf.kf->numRegisters; ++i)
+        writer.writeExpr(sf.locals.get()[i].value);
+    }
+
+    bool spillSegments = sf.segments.use_count() == 1;
+    writer.writeNumber(spillSegments);
+    if (spillSegments) {
+      for (unsigned i = 0; i < sf.kf->numRegisters; ++i)
+        writer.writeExpr(sf.segments.get()[i]);
+    }
+  }
+
+  // object states nobody but this address space refers to
+  std::vector<ObjectState *> objectStates;
+  for (const auto &pair : state.addressSpace.objects) {
+    ObjectState *os = pair.second.get();
+    if (os->_refCount.getCount() != 1)
+      continue;
+    spilled.objects.emplace_back(pair.first);
+    objectStates.push_back(os);
+  }
+
+  writer.writeNumber(objectStates.size());
+  for (ObjectState *os : objectStates) {
+    writer.writeNumber(os->size);
+    writer.writeNumber(os->readOnly);
+    writer.writeBytes(os->concreteStore);
+    writer.writeByteStates(os->byteStates, os->size);
+    writer.writeNumber(os->knownSymbolics != nullptr);
+    if (os->knownSymbolics) {
+      // only the symbolic bytes, there are usually few of them
+      std::vector<unsigned> offsets;
+      for (unsigned i = 0; i < os->size; ++i) {
+        if (!(*os->knownSymbolics)[i].isNull())
+          offsets.push_back(i);
+      }
+      writer.writeNumber(offsets.size());
+      for (unsigned offset : offsets) {
+        writer.writeNumber(offset);
+        writer.writeExpr((*os->knownSymbolics)[offset]);
+      }
+    }
+    writer.writeUpdates(os->updates);
+  }
+
+  writer.writeNumber(state.constraints.size());
+  for (const auto &constraint : state.constraints)
+    writer.writeExpr(constraint);
+
+  out.close();
+  if (!out) {
+    klee_warning("unable to write spilled state to %s",
+                 spilled.fileName.c_str());
+    std::remove(spilled.fileName.c_str());
+    return false;
+  }
+
+  // everything is on disk, release it
+  for (StackFrame &sf : state.stack) {
+    if (sf.locals.use_count() == 1)
+      sf.locals.reset();
+    if (sf.segments.use_count() == 1)
+      sf.segments.reset();
+  }
+  for (const auto &mo : spilled.objects)
+    state.addressSpace.unbindObject(mo.get());
+  state.constraints = ConstraintSet();
+
+  spilledStates.emplace(&state, std::move(spilled));
+  return true;
+}
+
+void StateSerializer::restore(ExecutionState &state) {
+  auto it = spilledStates.find(&state);
+  assert(it != spilledStates.end() && "state is not spilled");
+  const SpilledState &spilled = it->second;
+
+  std::ifstream in(spilled.fileName, std::ios::binary);
+  if (!in)
+    klee_error("unable to read spilled state from %s",
+               spilled.fileName.c_str());
+  SpillReader reader(in);
+
+  for (StackFrame &sf : state.stack) {
+    if (reader.readNumber()) {
+      sf.locals.reset(new Cell[sf.kf->numRegisters],
+                      std::default_delete<Cell[]>());
+      for (unsigned i = 0; i < sf.kf->numRegisters; ++i)
+        sf.locals.get()[i].value = reader.readExpr();
+    }
+
+    if (reader.readNumber()) {
+      sf.segments.reset(new ref<ConstantExpr>[sf.kf->numRegisters],
+                        std::default_delete<ref<ConstantExpr>[]>());
+      for (unsigned i = 0; i < sf.kf->numRegisters; ++i) {
+        ref<Expr> segment = reader.readExpr();
+        if (!segment.isNull())
+          sf.segments.get()[i] = cast<ConstantExpr>(segment);
+      }
+    }
+  }
+
+  uint64_t numObjects = reader.readNumber();
+  assert(numObjects == spilled.objects.size() && "corrupted spilled state");
+  for (const auto &mo : spilled.objects) {
+    auto *os = new ObjectState(mo.get());
+    unsigned size = reader.readNumber();
+    assert(size == os->size && "corrupted spilled state");
+    (void)size;
+
+    os->readOnly = reader.readNumber();
+    reader.readBytes(os->concreteStore);
+    os->byteStates = reader.readByteStates(os->size);
+    if (reader.readNumber()) {
+      os->knownSymbolics = new ObjectState::SymbolicStore(os->size);
+      for (uint64_t i = reader.readNumber(); i != 0; --i) {
+        unsigned offset = reader.readNumber();
+        os->knownSymbolics->set(offset, reader.readExpr());
+      }
+    }
+    os->updates = reader.readUpdates();
+
+    state.addressSpace.bindObject(mo.get(), os);
+  }
+
+  ConstraintSet::constraints_ty constraints(reader.readNumber());
+  for (auto &constraint : constraints)
+    constraint = reader.readExpr();
+  state.constraints = ConstraintSet(constraints);
+
+  if (!in)
+    klee_error("spilled state %s is corrupted", spilled.fileName.c_str());
+
+  in.close();
+  std::remove(spilled.fileName.c_str());
+  spilledStates.erase(it);
+}
@@ -0,0 +1,68 @@
+//===-- StateSerializer.h ---------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATESERIALIZER_H
+#define KLEE_STATESERIALIZER_H
+
+#include "klee/ADT/Ref.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+class ExecutionState;
+class MemoryObject;
+
+/// Moves the memory heavy parts of execution states to disk and back: the
+/// registers of the stack frames, the contents of the address space and the
+/// constraints. Parts still shared with other states stay in memory, since
+/// writing them out would not free anything. Everything else of a spilled
+/// state (program counter, frame layout, path information) stays in memory
+/// as well, so the state keeps its place in the process tree and can be
+/// handed to the searcher again once it is restored.
+///
+/// Arrays, update lists and expressions are written in a compact binary
+/// format that preserves their sharing within a state. Arrays and memory
+/// objects are referenced by address, so a spilled state can only be
+/// restored by the process that wrote it.
+class StateSerializer {
+  struct SpilledState {
+    std::string fileName;
+    /// Memory objects whose contents were spilled. Keeping them alive
+    /// prevents their addresses from being handed out again.
+    std::vector<ref<const MemoryObject>> objects;
+  };
+
+  std::string directory;
+  std::unordered_map<const ExecutionState *, SpilledState> spilledStates;
+
+public:
+  explicit StateSerializer(std::string directory);
+  ~StateSerializer();
+
+  StateSerializer(const StateSerializer &) = delete;
+  StateSerializer &operator=(const StateSerializer &) = delete;
+
+  /// Writes the state to disk and releases the written parts.
+  /// \return false if the state could not be written, it is unchanged then
+  bool spill(ExecutionState &state);
+
+  /// Reads the parts of a spilled state back in.
+  void restore(ExecutionState &state);
+
+  bool isSpilled(const ExecutionState &state) const {
+    return spilledStates.count(&state) != 0;
+  }
+
+  std::size_t getNumSpilled() const { return spilledStates.size(); }
+};
+} // namespace klee
+
+#endif /* KLEE_STATESERIALIZER_H */
@@ -0,0 +1,74 @@
+//===-- StateSet.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATESET_H
+#define KLEE_STATESET_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+class ExecutionState;
+
+/// The set of live states of the executor. Insertion, removal and lookup
+/// are O(1): the states are kept in a dense vector and a hash map stores
+/// the position of every state in it. A removed state is replaced by the
+/// last one, so the iteration order only depends on the order of the
+/// insertions and removals, never on the addresses of the states.
+class StateSet {
+  std::vector<ExecutionState *> states;
+  std::unordered_map<const ExecutionState *, std::size_t> positions;
+
+public:
+  typedef std::vector<ExecutionState *>::const_iterator iterator;
+  typedef iterator const_iterator;
+
+  /// \return false if the state was already in the set
+  bool insert(ExecutionState *state) {
+    if (!positions.emplace(state, states.size()).second)
+      return false;
+    states.push_back(state);
+    return true;
+  }
+
+  template <class InputIt> void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  /// \return false if the state was not in the set
+  bool erase(const ExecutionState *state) {
+    auto it = positions.find(state);
+    if (it == positions.end())
+      return false;
+
+    std::size_t position = it->second;
+    positions.erase(it);
+    if (position != states.size() - 1) {
+      states[position] = states.back();
+      positions[states[position]] = position;
+    }
+    states.pop_back();
+    return true;
+  }
+
+  std::size_t count(const ExecutionState *state) const {
+    return positions.count(state);
+  }
+
+  bool empty() const { return states.empty(); }
+  std::size_t size() const { return states.size(); }
+
+  iterator begin() const { return states.begin(); }
+  iterator end() const { return states.end(); }
+};
+} // namespace klee
+
+#endif /* KLEE_STATESET_H */
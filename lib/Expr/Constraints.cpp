@@ -71,19 +71,24 @@ public:
 };
 
 bool ConstraintManager::rewriteConstraints(ExprVisitor &visitor) {
-  ConstraintSet old;
+  // the constraints before the first one the visitor changes are kept, the
+  // set only rebuilds the suffix starting there
+  ConstraintSet old = constraints;
   bool changed = false;
 
-  std::swap(constraints, old);
+  std::size_t index = 0;
   for (auto &ce : old) {
     ref<Expr> e = visitor.visit(ce);
 
     if (e!=ce) {
+      if (!changed)
+        constraints.constraints.truncate(index);
       addConstraintInternal(e); // enable further reductions
       changed = true;
-    } else {
+    } else if (changed) {
       constraints.push_back(ce);
     }
+    ++index;
   }
 
   return changed;
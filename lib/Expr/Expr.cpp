@@ -333,6 +333,27 @@ void Expr::dump() const {
 
 /***/
 
+ConstantExpr *ConstantExpr::getSmall(Width w, uint64_t v) {
+  unsigned widthIndex;
+  switch (w) {
+  case Expr::Bool:  widthIndex = 0; break;
+  case Expr::Int8:  widthIndex = 1; break;
+  case Expr::Int16: widthIndex = 2; break;
+  case Expr::Int32: widthIndex = 3; break;
+  case Expr::Int64: widthIndex = 4; break;
+  default: return nullptr;
+  }
+
+  static std::vector<ref<ConstantExpr>> smallConstants(
+      5 * numSmallValues);
+  ref<ConstantExpr> &c = smallConstants[widthIndex * numSmallValues + v];
+  if (c.isNull()) {
+    c = new ConstantExpr(llvm::APInt(w, v));
+    c->computeHash();
+  }
+  return c.get();
+}
+
 ref<Expr> ConstantExpr::fromMemory(void *address, Width width) {
   switch (width) {
   case  Expr::Bool: return ConstantExpr::create(*(( uint8_t*) address), width);
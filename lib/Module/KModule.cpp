@@ -473,6 +473,10 @@ KFunction::KFunction(llvm::Function *_function,
       Instruction *inst = &*it;
       ki->inst = inst;
       ki->dest = registerMap[inst];
+      ki->opcode = inst->getOpcode();
+      ki->width = inst->getType()->isSized()
+                      ? km->targetData->getTypeSizeInBits(inst->getType())
+                      : 0;
 
       if (isa<CallInst>(it) || isa<InvokeInst>(it)) {
 #if LLVM_VERSION_CODE >= LLVM_VERSION(8, 0)
@@ -0,0 +1,46 @@
+// REQUIRES: not-msan
+// Memsan adds additional memory that overflows the counter
+// Check that the memory of freed objects no longer counts against
+// --max-memory: the model of the objects allocated first takes more than the
+// cap, once they are freed forking must be possible again.
+
+// RUN: %clang -emit-llvm -g -c %s -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --max-memory=100 %t.bc 2>&1 | FileCheck %s
+
+#include "klee/klee.h"
+
+#include <stdlib.h>
+
+#define NUM_OBJECTS 200000
+
+static void *objects[NUM_OBJECTS];
+
+int main() {
+  int i;
+  volatile int x = 0;
+
+  for (i = 0; i < NUM_OBJECTS; i++)
+    objects[i] = malloc(16);
+  for (i = 0; i < NUM_OBJECTS; i++)
+    free(objects[i]);
+
+  // Ensure we hit the periodic check after the last free
+  for (i = 0; i < 200000; i++)
+    x += i;
+
+  // CHECK-NOT: skipping fork (memory cap exceeded)
+  // CHECK-NOT: states (over memory cap
+  unsigned n = klee_range(0, 16, "n");
+  if (n & 1)
+    x++;
+  if (n & 2)
+    x++;
+  if (n & 4)
+    x++;
+  if (n & 8)
+    x++;
+
+  // CHECK: KLEE: done: completed paths = 16
+  return 0;
+}
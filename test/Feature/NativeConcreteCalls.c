@@ -0,0 +1,44 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -g -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --native-concrete-calls --all-external-warnings %t1.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --native-concrete-calls --external-calls=none %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-NONE %s
+// RUN: test -f %t.klee-out/test000001.user.err
+
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+int counter;
+int buffer[4];
+
+int step(int x, int k) {
+  counter += x;
+  for (int i = 0; i < 4; ++i)
+    buffer[i] += x * i;
+  return counter + abs(k);
+}
+
+int main() {
+  // everything is concrete, so step and abs run natively and the globals
+  // they wrote are read back into the address space
+  // CHECK-NOT: calling external: abs(1)
+  // CHECK-NONE: Disallowed call to external function: abs
+  assert(step(3, 1) == 4);
+  assert(counter == 3 && buffer[3] == 9);
+
+  // a symbolic argument is not passed to native code, the call is interpreted
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  // CHECK: calling external: abs(2)
+  assert(step(x, 2) == 3 + x + 2);
+
+  // neither is a call that reaches a symbolic byte, counter is symbolic now
+  // CHECK: calling external: abs(3)
+  assert(step(1, 3) == 3 + x + 1 + 3);
+  assert(buffer[3] == 9 + 3 * x + 3);
+
+  // CHECK: KLEE: done: completed paths = 1
+  return 0;
+}
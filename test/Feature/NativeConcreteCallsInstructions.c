@@ -0,0 +1,49 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -g -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --native-concrete-calls --max-instructions=20000 %t1.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --max-instructions=20000 %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-INTERPRETED %s
+
+// checksum runs about ten million instructions when it is interpreted, which
+// is far beyond the instruction limit. Natively the whole call counts as a
+// single instruction and the path completes.
+
+#include "klee/klee.h"
+
+#include <assert.h>
+
+unsigned table[256];
+// symbolic, but checksum cannot reach it
+int unrelated[1024];
+
+unsigned checksum(const unsigned char *data, unsigned size, unsigned rounds) {
+  unsigned sum = 0;
+  for (unsigned r = 0; r < rounds; ++r)
+    for (unsigned i = 0; i < size; ++i)
+      sum = table[(sum ^ data[i]) & 0xff] ^ (sum >> 8);
+  return sum;
+}
+
+int main() {
+  unsigned char data[64];
+  for (unsigned i = 0; i < 256; ++i)
+    table[i] = i * 2654435761u;
+  for (unsigned i = 0; i < sizeof(data); ++i)
+    data[i] = i;
+  klee_make_symbolic(unrelated, sizeof(unrelated), "unrelated");
+
+  // the same result as one round computed by the interpreter
+  unsigned once = checksum(data, sizeof(data), 1);
+  unsigned sum = 0;
+  for (unsigned i = 0; i < sizeof(data); ++i)
+    sum = table[(sum ^ data[i]) & 0xff] ^ (sum >> 8);
+  assert(once == sum);
+
+  checksum(data, sizeof(data), 150000);
+  return 0;
+}
+// CHECK-NOT: halting execution
+// CHECK: KLEE: done: completed paths = 1
+
+// CHECK-INTERPRETED: halting execution, dumping remaining states
+// CHECK-INTERPRETED: KLEE: done: completed paths = 0
@@ -0,0 +1,38 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -g -o %t1.bc
+// RUN: rm -rf %t.normal.klee-out %t.speculative.klee-out
+// RUN: %klee --output-dir=%t.normal.klee-out %t1.bc 2>&1 | FileCheck %s
+// RUN: %klee --output-dir=%t.speculative.klee-out --speculative-fork %t1.bc 2>&1 | FileCheck %s
+// RUN: ls %t.normal.klee-out | grep -c ktest | FileCheck --check-prefix=CHECK-TESTS %s
+// RUN: ls %t.speculative.klee-out | grep -c ktest | FileCheck --check-prefix=CHECK-TESTS %s
+// RUN: ls %t.speculative.klee-out | not grep .err
+// RUN: %klee-stats %t.normal.klee-out %t.speculative.klee-out | FileCheck --check-prefix=CHECK-STATS %s
+
+#include "klee/klee.h"
+
+#include <stdlib.h>
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+
+  if (x > 10) {
+    // a speculative fork creates a state for the infeasible side as well, it
+    // is discarded once selected, without a test case and without covering
+    // the branch
+    if (x < 5)
+      abort();
+    return 1;
+  }
+  return 0;
+}
+
+// CHECK-NOT: abort failure
+// CHECK: KLEE: done: completed paths = 2
+// CHECK: KLEE: done: partially completed paths = 0
+// CHECK: KLEE: done: generated tests = 2
+
+// CHECK-TESTS: 2
+
+// The coverage of both runs is the same.
+// CHECK-STATS: {{.*}}normal.klee-out{{ *}}|{{[^|]*}}|{{[^|]*}}|[[ICOV:[^|]*]]|[[BCOV:[^|]*]]|
+// CHECK-STATS: {{.*}}speculative.klee-out{{ *}}|{{[^|]*}}|{{[^|]*}}|[[ICOV]]|[[BCOV]]|
@@ -0,0 +1,31 @@
+// RUN: %clang %s -g -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t1.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.klee-out/test000001.ptr.err -o -f %t.klee-out/test000002.ptr.err
+// RUN: not test -f %t.klee-out/test000003.ktest
+
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+int main() {
+  unsigned n = klee_range(1, 17, "n");
+  char *p = malloc(n);
+
+  // the size fits the default capacity, so it stays symbolic and there is
+  // one state for all sizes
+  assert(klee_get_obj_size(p) == n);
+
+  p[0] = 1;
+  p[n - 1] = 2;
+  assert(p[n - 1] == 2);
+
+  unsigned i = klee_range(0, 17, "i");
+  // CHECK: SymbolicSizeAllocation.c:[[@LINE+1]]: memory error: out of bound pointer
+  p[i] = 3;
+
+  free(p);
+  return 0;
+}
+// CHECK: KLEE: done: completed paths = 1
@@ -0,0 +1,29 @@
+// RUN: %clang %s -g -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --symbolic-size-capacity=64 %t1.bc 2>&1 | FileCheck %s
+// RUN: ls %t.klee-out | FileCheck --check-prefix=CHECK-FILES %s
+
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+int main() {
+  unsigned n = klee_range(1, 200, "n");
+  // CHECK: SymbolicSizeCapacity.c:[[@LINE+1]]: concretized symbolic size
+  char *p = malloc(n);
+
+  if (n <= 64) {
+    // up to the capacity the size stays symbolic
+    assert(klee_is_symbolic(klee_get_obj_size(p)));
+  } else {
+    // larger sizes are forked off and concretized
+    assert(!klee_is_symbolic(klee_get_obj_size(p)));
+  }
+  p[n - 1] = 1;
+
+  free(p);
+  return 0;
+}
+// CHECK: KLEE: done: completed paths = 2
+// CHECK-FILES: .model.err
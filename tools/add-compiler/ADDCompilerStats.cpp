@@ -0,0 +1,13 @@
+#include "ADDCompilerStats.h"
+
+
+klee::Statistic klee::stats::symexPaths("SymexPaths", "Paths");
+klee::Statistic klee::stats::pathDiscoveryTime("PathDiscoveryTime", "Ptime");
+klee::Statistic klee::stats::symexTime("SymexTime", "SEtime");
+klee::Statistic klee::stats::symexJsonBytes("SymexJsonBytes", "SEjson");
+klee::Statistic klee::stats::addBuildTime("ADDBuildTime", "ADDtime");
+klee::Statistic klee::stats::addJsonBytes("ADDJsonBytes", "ADDjson");
+klee::Statistic klee::stats::addReadTime("ADDReadTime", "ADDread");
+klee::Statistic klee::stats::codegenTime("CodegenTime", "CGtime");
+klee::Statistic klee::stats::generatedInstructions("GeneratedInstructions", "CGinst");
+klee::Statistic klee::stats::foldedConditions("FoldedConditions", "CGfold");
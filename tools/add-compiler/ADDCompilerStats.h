@@ -0,0 +1,45 @@
+#ifndef KLEE_ADDCOMPILERSTATS_H
+#define KLEE_ADDCOMPILERSTATS_H
+
+
+#include <klee/Statistics/Statistic.h>
+
+
+namespace klee {
+    namespace stats {
+
+        /// Number of paths found by splitting the cfg at its cutpoints.
+        extern Statistic symexPaths;
+
+        /// Time spent splitting the cfg into paths (microseconds).
+        extern Statistic pathDiscoveryTime;
+
+        /// Time spent symbolically executing all paths (microseconds).
+        extern Statistic symexTime;
+
+        /// Size of the written symbolic execution results (bytes).
+        extern Statistic symexJsonBytes;
+
+        /// Time spent building the ADDs with the java library (microseconds).
+        extern Statistic addBuildTime;
+
+        /// Size of the ADDs read back from the java library (bytes).
+        extern Statistic addJsonBytes;
+
+        /// Time spent parsing the ADDs read back from the java library (microseconds).
+        extern Statistic addReadTime;
+
+        /// Time spent generating llvm ir from the ADDs (microseconds).
+        extern Statistic codegenTime;
+
+        /// Number of llvm ir instructions in the generated functions.
+        extern Statistic generatedInstructions;
+
+        /// Number of ADD condition nodes removed because their outcome was already decided.
+        extern Statistic foldedConditions;
+
+    }
+}
+
+
+#endif //KLEE_ADDCOMPILERSTATS_H
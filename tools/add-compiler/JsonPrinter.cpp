@@ -2,14 +2,37 @@
 // Created by simon on 22.07.21.
 //
 
-#include <fstream>
-
 #include <nlohmann/json.hpp>
 #include <iostream>
 
+#include <klee/Support/FileHandling.h>
+
 #include "JsonPrinter.h"
 
+
+JsonPrinter::JsonPrinter(const std::string &outputFile) {
+    this->firstEntry = true;
+
+    std::string error;
+    this->outputStream = klee::klee_open_output_file(outputFile, error);
+
+    if (!this->outputStream) {
+        std::cout << "Could not open " << outputFile << ": " << error << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    *this->outputStream << "[\n";
+}
+
+JsonPrinter::~JsonPrinter() {
+    this->close();
+}
+
 void JsonPrinter::print(klee::Path *path) {
+    this->writeEntry(this->toJson(path));
+}
+
+nlohmann::json JsonPrinter::toJson(klee::Path *path) {
     klee::ConstraintSet constraints = path->getConstraints();
 
     std::string conditionString;
@@ -19,7 +42,7 @@ void JsonPrinter::print(klee::Path *path) {
     } else {
         // conditions are split in the resulting constraint set, join them together using AND
         auto condition = *constraints.begin();
-        for (auto constraintIt = constraints.begin() + 1; constraintIt != constraints.end(); constraintIt++) {
+        for (auto constraintIt = std::next(constraints.begin()); constraintIt != constraints.end(); constraintIt++) {
             condition = klee::AndExpr::create(condition, *constraintIt);
         }
         printExpression(condition, &conditionString);
@@ -57,7 +80,7 @@ void JsonPrinter::print(klee::Path *path) {
         }
     }
 
-    this->jsonObject += {
+    return {
             {"start-cutpoint", startCutpointName},
             {"target-cutpoint", targetCutpointName},
             {"condition", conditionString},
@@ -65,6 +88,14 @@ void JsonPrinter::print(klee::Path *path) {
     };
 }
 
+void JsonPrinter::writeEntry(const nlohmann::json &entry) {
+    if (!this->firstEntry) {
+        *this->outputStream << ",\n";
+    }
+    *this->outputStream << entry.dump(4);
+    this->firstEntry = false;
+}
+
 void JsonPrinter::printExpression(klee::ref<klee::Expr> expression, std::string *resultString) {
     switch (expression->getKind()) {
         case klee::Expr::Kind::Constant: {
@@ -252,11 +283,13 @@ void JsonPrinter::escapeVariableName(std::string *variableName) {
     }
 }
 
-void JsonPrinter::writeToFile(std::string outputFile) {
-    std::ofstream outputFileStream;
-    outputFileStream.open(outputFile);
+void JsonPrinter::close() {
+    if (!this->outputStream) {
+        return;
+    }
 
-    outputFileStream << this->jsonObject.dump(4);
+    *this->outputStream << "\n]";
 
-    outputFileStream.close();
+    // destroying the stream flushes it
+    this->outputStream.reset();
 }
\ No newline at end of file
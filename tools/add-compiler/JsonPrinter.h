@@ -6,27 +6,42 @@
 #define KLEE_JSONPRINTER_H
 
 
+#include <memory>
+
 #include <klee/ADT/Ref.h>
 #include "klee/Core/Path.h"
 #include <klee/Expr/Expr.h>
 
+#include <llvm/Support/raw_ostream.h>
+
 #include <nlohmann/json.hpp>
 
 
+/// Writes symbolic execution results incrementally.
+/// Every path is serialized and written out as soon as it is printed, so the results of a function
+/// never have to be held in memory as a whole.
 class JsonPrinter {
 private:
-    nlohmann::json jsonObject;
+    std::unique_ptr<llvm::raw_ostream> outputStream;
+    bool firstEntry;
 
 public:
+    explicit JsonPrinter(const std::string &outputFile);
+    ~JsonPrinter();
+
     void print(klee::Path *path);
 
+    nlohmann::json toJson(klee::Path *path);
+
+    void writeEntry(const nlohmann::json &entry);
+
     void printExpression(klee::ref<klee::Expr> expression, std::string *resultString);
 
     void printBinaryExpression(std::string op, klee::ref<klee::Expr> expression, std::string *result);
 
     void escapeVariableName(std::string *variableName);
 
-    void writeToFile(std::string outputFile);
+    void close();
 };
 
 
@@ -0,0 +1,258 @@
+#include <cerrno>
+#include <iostream>
+#include <map>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <klee/Statistics/Statistics.h>
+#include <klee/System/Time.h>
+
+#include "PathDistributor.h"
+
+
+namespace {
+    const uint32_t STOP_WORKER = UINT32_MAX;
+
+    struct PathResultHeader {
+        uint32_t pathIndex;
+        uint32_t statisticsCount;
+        uint64_t symexTimeMicroseconds;
+        uint64_t entryLength;
+        uint64_t returnValueNameLength;
+    };
+
+    struct PathResult {
+        uint64_t symexTimeMicroseconds;
+        std::string entry;
+    };
+
+    struct Worker {
+        pid_t pid;
+        int socket;
+        bool busy;
+    };
+}
+
+
+PathDistributor::PathDistributor(unsigned processes, klee::ADDInterpreter *executor) {
+    this->processes = processes;
+    this->executor = executor;
+    this->coordinatorSocket = -1;
+    this->currentFunction = nullptr;
+    this->currentPathIndex = 0;
+}
+
+void PathDistributor::runFunction(klee::FunctionEvaluation *functionEvaluation, const ResultCallback &processResult) {
+    klee::PathList &paths = functionEvaluation->getPathList();
+
+    // anything still buffered would otherwise be written out by every worker as well
+    std::cout.flush();
+
+    std::vector<Worker> workers;
+    for (unsigned i = 0; i < this->processes; i++) {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+            std::cout << "could not create socket for worker process" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cout << "could not fork worker process" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        if (pid == 0) {
+            close(sockets[0]);
+            for (Worker &worker : workers) {
+                close(worker.socket);
+            }
+
+            this->coordinatorSocket = sockets[1];
+            this->runWorker(functionEvaluation);
+
+            // skip destructors and exit handlers, they belong to the coordinator
+            std::cout.flush();
+            _exit(EXIT_SUCCESS);
+        }
+
+        close(sockets[1]);
+        workers.push_back({pid, sockets[0], false});
+    }
+
+    uint32_t nextPath = 0;
+    uint32_t nextFinishedPath = 0;
+    std::map<uint32_t, PathResult> finishedPaths;
+
+    for (Worker &worker : workers) {
+        if (nextPath < paths.size()) {
+            sendPathIndex(worker.socket, nextPath++);
+            worker.busy = true;
+        } else {
+            sendPathIndex(worker.socket, STOP_WORKER);
+        }
+    }
+
+    while (nextFinishedPath < paths.size()) {
+        std::vector<pollfd> pollFds;
+        std::vector<Worker *> polledWorkers;
+        for (Worker &worker : workers) {
+            if (worker.busy) {
+                pollFds.push_back({worker.socket, POLLIN, 0});
+                polledWorkers.push_back(&worker);
+            }
+        }
+
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cout << "could not wait for worker processes" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        for (unsigned i = 0; i < pollFds.size(); i++) {
+            if (!pollFds[i].revents) continue;
+            Worker *worker = polledWorkers[i];
+
+            PathResultHeader header;
+            std::vector<uint64_t> statistics;
+            PathResult result;
+            std::string returnValueName;
+
+            bool success = readFully(worker->socket, &header, sizeof(header));
+            if (success) {
+                statistics.resize(header.statisticsCount);
+                result.symexTimeMicroseconds = header.symexTimeMicroseconds;
+                result.entry.resize(header.entryLength);
+                returnValueName.resize(header.returnValueNameLength);
+
+                success = readFully(worker->socket, statistics.data(), statistics.size() * sizeof(uint64_t))
+                          && readFully(worker->socket, &result.entry[0], result.entry.size())
+                          && readFully(worker->socket, &returnValueName[0], returnValueName.size());
+            }
+
+            if (!success) {
+                std::cout << "worker process " << worker->pid << " terminated unexpectedly" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            // the return value is only found while executing a path, the code generators need it in the coordinator
+            if (!returnValueName.empty() && !functionEvaluation->setReturnValueName(returnValueName)) {
+                std::cout << "different return values on different paths are not allowed" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            for (unsigned s = 0; s < statistics.size(); s++) {
+                klee::theStatisticManager->incrementStatistic(klee::theStatisticManager->getStatistic(s),
+                                                              statistics[s]);
+            }
+            finishedPaths[header.pathIndex] = std::move(result);
+
+            if (nextPath < paths.size()) {
+                sendPathIndex(worker->socket, nextPath++);
+            } else {
+                sendPathIndex(worker->socket, STOP_WORKER);
+                worker->busy = false;
+            }
+        }
+
+        // pass on the results in path order, so the output does not depend on the scheduling
+        for (auto it = finishedPaths.find(nextFinishedPath); it != finishedPaths.end();
+             it = finishedPaths.find(nextFinishedPath)) {
+            klee::Path *path = paths[nextFinishedPath];
+            path->setSymexTime(klee::time::microseconds(it->second.symexTimeMicroseconds));
+
+            processResult(path, nlohmann::json::parse(it->second.entry));
+
+            finishedPaths.erase(it);
+            nextFinishedPath++;
+        }
+    }
+
+    for (Worker &worker : workers) {
+        close(worker.socket);
+        waitpid(worker.pid, nullptr, 0);
+    }
+}
+
+void PathDistributor::runWorker(klee::FunctionEvaluation *functionEvaluation) {
+    klee::PathList &paths = functionEvaluation->getPathList();
+    this->currentFunction = functionEvaluation;
+
+    // the statistics up to the fork are already counted by the coordinator
+    this->reportedStatistics.resize(klee::theStatisticManager->getNumStatistics());
+    for (unsigned i = 0; i < this->reportedStatistics.size(); i++) {
+        this->reportedStatistics[i] = klee::theStatisticManager->getStatistic(i).getValue();
+    }
+
+    while (readFully(this->coordinatorSocket, &this->currentPathIndex, sizeof(this->currentPathIndex))
+           && this->currentPathIndex != STOP_WORKER) {
+        // the executor passes the finished path to the handler, which calls sendResult
+        this->executor->runPath(functionEvaluation, paths[this->currentPathIndex]);
+    }
+
+    close(this->coordinatorSocket);
+}
+
+void PathDistributor::sendResult(klee::Path *path, const nlohmann::json &entry) {
+    std::vector<uint64_t> statistics(this->reportedStatistics.size());
+    for (unsigned i = 0; i < statistics.size(); i++) {
+        uint64_t value = klee::theStatisticManager->getStatistic(i).getValue();
+        statistics[i] = value - this->reportedStatistics[i];
+        this->reportedStatistics[i] = value;
+    }
+
+    std::string serializedEntry = entry.dump();
+    const std::string &returnValueName = this->currentFunction->getReturnValueName();
+
+    PathResultHeader header;
+    header.pathIndex = this->currentPathIndex;
+    header.statisticsCount = statistics.size();
+    header.symexTimeMicroseconds = path->getSymexTime().toMicroseconds();
+    header.entryLength = serializedEntry.size();
+    header.returnValueNameLength = returnValueName.size();
+
+    if (!writeFully(this->coordinatorSocket, &header, sizeof(header))
+        || !writeFully(this->coordinatorSocket, statistics.data(), statistics.size() * sizeof(uint64_t))
+        || !writeFully(this->coordinatorSocket, serializedEntry.data(), serializedEntry.size())
+        || !writeFully(this->coordinatorSocket, returnValueName.data(), returnValueName.size())) {
+        // the coordinator is gone, nobody is interested in the remaining paths
+        _exit(EXIT_FAILURE);
+    }
+}
+
+void PathDistributor::sendPathIndex(int socket, uint32_t pathIndex) {
+    if (!writeFully(socket, &pathIndex, sizeof(pathIndex))) {
+        std::cout << "could not send path to worker process" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+bool PathDistributor::readFully(int socket, void *buffer, size_t size) {
+    auto *position = static_cast<char *>(buffer);
+    while (size > 0) {
+        ssize_t count = recv(socket, position, size, 0);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+
+        position += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool PathDistributor::writeFully(int socket, const void *buffer, size_t size) {
+    auto *position = static_cast<const char *>(buffer);
+    while (size > 0) {
+        // a terminated peer is reported as an error instead of raising SIGPIPE
+        ssize_t count = send(socket, position, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+
+        position += count;
+        size -= count;
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef KLEE_PATHDISTRIBUTOR_H
+#define KLEE_PATHDISTRIBUTOR_H
+
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <klee/Core/ADDInterpreter.h>
+#include <klee/Core/FunctionEvaluation.h>
+
+
+/// Distributes the symbolic execution of the paths of a function to several worker processes.
+/// The workers are forked from the coordinator for every function, so they share the loaded module and the
+/// path list without any handoff. The coordinator sends path indices over a local socket, the worker executes
+/// the path and sends back its json entry together with the statistics it collected and the name of the
+/// return value, which is only found while executing a path.
+/// The coordinator passes the entries on in path order and merges the statistics into its own.
+class PathDistributor {
+public:
+    typedef std::function<void(klee::Path *, const nlohmann::json &)> ResultCallback;
+
+private:
+    unsigned processes;
+    klee::ADDInterpreter *executor;
+
+    /// socket to the coordinator if this process is a worker, -1 in the coordinator
+    int coordinatorSocket;
+    klee::FunctionEvaluation *currentFunction;
+    uint32_t currentPathIndex;
+    std::vector<uint64_t> reportedStatistics;
+
+public:
+    PathDistributor(unsigned processes, klee::ADDInterpreter *executor);
+
+    void runFunction(klee::FunctionEvaluation *functionEvaluation, const ResultCallback &processResult);
+
+    bool isWorker() const {
+        return this->coordinatorSocket != -1;
+    }
+
+    /// Called by a worker as soon as it finished a path.
+    void sendResult(klee::Path *path, const nlohmann::json &entry);
+
+private:
+    void runWorker(klee::FunctionEvaluation *functionEvaluation);
+
+    static void sendPathIndex(int socket, uint32_t pathIndex);
+
+    static bool readFully(int socket, void *buffer, size_t size);
+
+    static bool writeFully(int socket, const void *buffer, size_t size);
+};
+
+
+#endif //KLEE_PATHDISTRIBUTOR_H
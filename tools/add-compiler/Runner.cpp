@@ -12,27 +12,39 @@
 #include <klee/Support/ErrorHandling.h>
 #include <klee/Support/FileHandling.h>
 #include <klee/Support/ModuleUtil.h>
+#include <klee/Support/Timer.h>
+#include <klee/Statistics/TimerStatIncrementer.h>
 #include <klee/Core/ADDInterpreter.h>
 #include "klee/Core/FunctionEvaluation.h"
 
 #include "Runner.h"
 #include "JsonPrinter.h"
+#include "ADDCompilerStats.h"
 
 
 Runner::Runner(int argc, char **argv, std::string outputDirectory) {
     this->argc = argc;
     this->argv = argv;
     this->outputDirectory = outputDirectory;
+
+    this->vectorWidth = 0;
+    this->simplifyADDs = false;
+    this->processes = 1;
+    this->symexPrinter = nullptr;
+    this->pathDistributor = nullptr;
 }
 
 Runner::~Runner() {
     delete this->codeGenerator;
+    delete this->statisticsWriter;
 };
 
 void Runner::init() {
     this->parseArguments();
     this->prepareRunDirectory();
 
+    this->statisticsWriter = new StatisticsWriter(this->outputDirectory);
+
     llvm::InitializeNativeTarget();
 
     std::string error;
@@ -61,7 +73,8 @@ void Runner::init() {
     // Push the module as the first entry
     this->loadedModules.emplace_back(std::move(module));
 
-    auto *options = new CodeGeneratorOptions(&this->llvmContext, this->outputDirectory);
+    auto *options = new CodeGeneratorOptions(&this->llvmContext, this->outputDirectory, this->vectorWidth,
+                                             this->simplifyADDs);
     this->codeGenerator = new CodeGenerator(options);
 }
 
@@ -73,7 +86,7 @@ void Runner::run() {
     }
 
     // create the interpreter and set the module in it
-    auto *executor = klee::ADDInterpreter::create(this->llvmContext);
+    auto *executor = klee::ADDInterpreter::create(this->llvmContext, this);
     klee::Interpreter::ModuleOptions moduleOptions(
             "",
             this->functions->front().getName(),
@@ -84,6 +97,10 @@ void Runner::run() {
     );
     llvm::Module *finalModule = executor->setModule(this->loadedModules, moduleOptions);
 
+    if (this->processes > 1) {
+        this->pathDistributor = new PathDistributor(this->processes, executor);
+    }
+
     for (llvm::Function &function : *this->functions) {
         if (function.isDeclaration()) {
             continue;
@@ -91,57 +108,132 @@ void Runner::run() {
 
         llvm::StringRef functionName = function.getName();
         std::cout << "[COMPILING] " << functionName.str() << std::endl;
+        this->statisticsWriter->beginFunction(functionName.str());
 
         // creating the object that will hold the symbolic execution results.
         // this also splits the cfg into acyclic subgraphs
+        klee::WallTimer pathDiscoveryTimer;
         klee::FunctionEvaluation functionEvaluation(&function);
+        klee::stats::pathDiscoveryTime += pathDiscoveryTimer.delta().toMicroseconds();
+        klee::stats::symexPaths += functionEvaluation.getPathList().size();
+
+        // the symbolic execution results are written out by processPath as soon as a path is finished
+        std::string symexFileName = this->getSymexFileName(functionName);
+        this->symexPrinter = new JsonPrinter(symexFileName);
+        {
+            klee::TimerStatIncrementer timer(klee::stats::symexTime);
+            if (this->pathDistributor) {
+                this->pathDistributor->runFunction(&functionEvaluation, [this](klee::Path *path,
+                                                                               const nlohmann::json &entry) {
+                    this->symexPrinter->writeEntry(entry);
+                    this->statisticsWriter->writePath(path);
+                });
+            } else {
+                executor->runFunction(&functionEvaluation);
+            }
+        }
+        delete this->symexPrinter;
+        this->symexPrinter = nullptr;
 
-        executor->runFunction(&functionEvaluation);
-
-        //
-        this->writeSymbolicExecutionResultsToJson(&functionEvaluation, functionName);
+        klee::stats::symexJsonBytes += getFileSize(symexFileName);
 
         this->callJavaLib(functionName);
 
-        nlohmann::json addJson;
-        this->readADDsFromJson(&addJson, functionName);
+        this->generateCode(&functionEvaluation, functionName);
 
-        this->generateCode(&functionEvaluation, &addJson);
+        this->statisticsWriter->endFunction();
     }
 
+    delete this->pathDistributor;
+    this->pathDistributor = nullptr;
     delete executor;
 
     this->codeGenerator->writeModule();
 }
 
+void Runner::processPath(klee::FunctionEvaluation *functionEvaluation, klee::Path *path) {
+    if (this->pathDistributor && this->pathDistributor->isWorker()) {
+        // worker processes only send their results, the coordinator writes them out
+        this->pathDistributor->sendResult(path, this->symexPrinter->toJson(path));
+    } else {
+        this->symexPrinter->print(path);
+        this->statisticsWriter->writePath(path);
+    }
+
+    // the expressions of the path are not needed anymore once they are written
+    path->releaseResults();
+}
+
 void Runner::parseArguments() {
-    if (this->argc != 2) {
+    for (int i = 1; i < this->argc; i++) {
+        std::string argument = this->argv[i];
+
+        if (argument == "--simplify-adds") {
+            this->simplifyADDs = true;
+        } else if (argument.rfind("--vector-width=", 0) == 0) {
+            // a single lane would just be a slower copy of the scalar function
+            if (!parseNumber(argument, 2, &this->vectorWidth)) {
+                this->inputFile.clear();
+                break;
+            }
+        } else if (argument.rfind("--processes=", 0) == 0) {
+            if (!parseNumber(argument, 1, &this->processes)) {
+                this->inputFile.clear();
+                break;
+            }
+        } else if (this->inputFile.empty() && argument.rfind("--", 0) != 0) {
+            this->inputFile = argument;
+        } else {
+            this->inputFile.clear();
+            break;
+        }
+    }
+
+    if (this->inputFile.empty()) {
         std::cout << "Invalid arguments, call the ADD-Compiler like this:" << std::endl;
-        std::cout << "./add-compiler <some/llvm/ir/file>.bc" << std::endl;
+        std::cout << "./add-compiler [--vector-width=N] [--simplify-adds] [--processes=N] <some/llvm/ir/file>.bc" << std::endl;
+        std::cout << "  --vector-width=N   additionally generate <function>_vN, which processes N >= 2 calls at once" << std::endl;
+        std::cout << "  --simplify-adds    remove ADD conditions that are already decided by the conditions above them" << std::endl;
+        std::cout << "  --processes=N      symbolically execute the paths of a function with N worker processes" << std::endl;
         exit(EXIT_FAILURE);
     }
+}
 
-    this->inputFile = this->argv[1];
+bool Runner::parseNumber(const std::string &argument, unsigned minimum, unsigned *result) {
+    std::string value = argument.substr(argument.find('=') + 1);
+    if (value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos) {
+        std::cout << "Invalid value in " << argument << std::endl;
+        return false;
+    }
+
+    unsigned number = std::stoul(value);
+    if (number < minimum) {
+        std::cout << "Invalid value in " << argument << ", the minimum is " << minimum << std::endl;
+        return false;
+    }
+
+    *result = number;
+    return true;
 }
 
 void Runner::prepareRunDirectory() {
     mkdir(this->outputDirectory.c_str(), 0777);
 }
 
-void Runner::writeSymbolicExecutionResultsToJson(klee::FunctionEvaluation *functionEvaluation, llvm::StringRef functionName) {
-    JsonPrinter printer;
-
-    for (auto *path : functionEvaluation->getPathList()) {
-        printer.print(path);
-    }
+std::string Runner::getSymexFileName(llvm::StringRef functionName) {
+    return this->outputDirectory + "/" + functionName.str() + ".symex.json";
+}
 
-    printer.writeToFile(this->outputDirectory + "/" + functionName.str() + ".symex.json");
+std::string Runner::getADDsFileName(llvm::StringRef functionName) {
+    return this->outputDirectory + "/" + functionName.str() + ".adds.json";
 }
 
 void Runner::callJavaLib(llvm::StringRef functionName) {
+    klee::TimerStatIncrementer timer(klee::stats::addBuildTime);
+
     char command[256]; // todo fix this so it doesnt crash if the command gets longer than 256 chars
-    sprintf(command, "java -jar path-to-add.jar -i %s/%s.symex.json -o %s/%s.adds.json",
-            this->outputDirectory.c_str(), functionName.str().c_str(), this->outputDirectory.c_str(), functionName.str().c_str());
+    sprintf(command, "java -jar path-to-add.jar -i %s -o %s",
+            this->getSymexFileName(functionName).c_str(), this->getADDsFileName(functionName).c_str());
 
     FILE *commandOutput;
     commandOutput = popen(command, "r");
@@ -160,12 +252,55 @@ void Runner::callJavaLib(llvm::StringRef functionName) {
     } while (success != nullptr);
 }
 
-void Runner::readADDsFromJson(nlohmann::json *addJson, llvm::StringRef functionName) {
-    std::ifstream addsInputFile(this->outputDirectory + "/" + functionName.str() + ".adds.json");
+void Runner::readADDsFromJson(llvm::StringRef functionName, const std::function<void(nlohmann::json &)> &processADD) {
+    std::string inputFile = this->getADDsFileName(functionName);
+    std::ifstream addsInputFile(inputFile);
+
+    // the time spent processing the ADDs does not count as reading
+    klee::WallTimer readTimer;
+    klee::time::Span processTime;
+
+    // every element of the top level array is handed out as soon as it is parsed completely.
+    // returning false discards it, so the array is never built up in memory.
+    nlohmann::json::parser_callback_t callback = [&processADD, &processTime](int depth,
+                                                                             nlohmann::json::parse_event_t event,
+                                                                             nlohmann::json &parsed) {
+        if (depth == 1 && event == nlohmann::json::parse_event_t::object_end) {
+            klee::WallTimer processTimer;
+            processADD(parsed);
+            processTime += processTimer.delta();
+            return false;
+        }
+        return true;
+    };
+    // only the emptied top level array is left, all of its elements were discarded above
+    nlohmann::json discarded = nlohmann::json::parse(addsInputFile, callback);
+    (void) discarded;
+
+    klee::stats::addReadTime += (readTimer.delta() - processTime).toMicroseconds();
+    klee::stats::addJsonBytes += getFileSize(inputFile);
+}
 
-    addsInputFile >> *addJson;
+void Runner::generateCode(klee::FunctionEvaluation *functionEvaluation, llvm::StringRef functionName) {
+    // the ADDs are generated while they are parsed, the parsing is timed by readADDsFromJson
+    {
+        klee::TimerStatIncrementer timer(klee::stats::codegenTime);
+        this->codeGenerator->beginFunction(functionEvaluation);
+    }
+    this->readADDsFromJson(functionName, [this](nlohmann::json &add) {
+        klee::TimerStatIncrementer timer(klee::stats::codegenTime);
+        this->codeGenerator->generateADD(&add);
+    });
+    {
+        klee::TimerStatIncrementer timer(klee::stats::codegenTime);
+        this->codeGenerator->finishFunction();
+    }
 }
 
-void Runner::generateCode(klee::FunctionEvaluation *functionEvaluation, nlohmann::json *addJson) {
-    this->codeGenerator->generateFunction(functionEvaluation, addJson);
+uint64_t Runner::getFileSize(const std::string &fileName) {
+    struct stat fileStat{};
+    if (stat(fileName.c_str(), &fileStat) != 0) {
+        return 0;
+    }
+    return fileStat.st_size;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #define KLEE_RUNNER_H
 
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -13,12 +14,16 @@
 
 #include <llvm/IR/IRBuilder.h>
 
+#include <klee/Core/ADDInterpreter.h>
 #include <klee/Core/Interpreter.h>
 #include <klee/Core/FunctionEvaluation.h>
 #include "code-generation/CodeGenerator.h"
+#include "JsonPrinter.h"
+#include "PathDistributor.h"
+#include "StatisticsWriter.h"
 
 
-class Runner {
+class Runner : public klee::ADDInterpreterHandler {
 private:
     int argc;
     char **argv;
@@ -26,27 +31,41 @@ private:
     std::string inputFile;
     std::string outputDirectory;
 
+    unsigned vectorWidth;
+    bool simplifyADDs;
+    unsigned processes;
+
     llvm::LLVMContext llvmContext;
     std::vector<std::unique_ptr<llvm::Module>> loadedModules;
     llvm::SymbolTableList<llvm::Function> *functions;
 
     CodeGenerator *codeGenerator;
+    StatisticsWriter *statisticsWriter;
+    JsonPrinter *symexPrinter;
+    PathDistributor *pathDistributor;
 
 public:
     Runner(int argc, char **argv, std::string outputDirectory);
-    ~Runner();
+    ~Runner() override;
 
     void init();
     void run();
 
+    void processPath(klee::FunctionEvaluation *functionEvaluation, klee::Path *path) override;
+
 private:
     void parseArguments();
+    static bool parseNumber(const std::string &argument, unsigned minimum, unsigned *result);
     void prepareRunDirectory();
 
-    void writeSymbolicExecutionResultsToJson(klee::FunctionEvaluation *functionEvaluation, llvm::StringRef functionName);
+    std::string getSymexFileName(llvm::StringRef functionName);
+    std::string getADDsFileName(llvm::StringRef functionName);
+
     void callJavaLib(llvm::StringRef functionName);
-    void readADDsFromJson(nlohmann::json *addJson, llvm::StringRef functionName);
-    void generateCode(klee::FunctionEvaluation *functionEvaluation, nlohmann::json *addJson);
+    void readADDsFromJson(llvm::StringRef functionName, const std::function<void(nlohmann::json &)> &processADD);
+    void generateCode(klee::FunctionEvaluation *functionEvaluation, llvm::StringRef functionName);
+
+    static uint64_t getFileSize(const std::string &fileName);
 };
 
 #endif //KLEE_RUNNER_H
@@ -0,0 +1,85 @@
+#include <klee/Solver/SolverStats.h>
+
+#include "StatisticsWriter.h"
+#include "ADDCompilerStats.h"
+
+
+StatisticsWriter::StatisticsWriter(const std::string &outputDirectory) {
+    this->functionsFile.open(outputDirectory + "/functions.csv");
+    this->pathsFile.open(outputDirectory + "/paths.csv");
+
+    // the order of this list determines the column order in functions.csv
+    this->statistics = {
+            &klee::stats::symexPaths,
+            &klee::stats::pathDiscoveryTime,
+            &klee::stats::symexTime,
+            &klee::stats::queries,
+            &klee::stats::queryTime,
+            &klee::stats::symexJsonBytes,
+            &klee::stats::addBuildTime,
+            &klee::stats::addJsonBytes,
+            &klee::stats::addReadTime,
+            &klee::stats::codegenTime,
+            &klee::stats::generatedInstructions,
+            &klee::stats::foldedConditions
+    };
+
+    this->writeHeaders();
+}
+
+void StatisticsWriter::beginFunction(const std::string &functionName) {
+    this->currentFunctionName = functionName;
+    this->currentPathNumber = 0;
+
+    // statistics are global counters, remember where they stood so we can write the delta for this function
+    this->functionStartValues.clear();
+    for (klee::Statistic *statistic : this->statistics) {
+        this->functionStartValues.push_back(statistic->getValue());
+    }
+}
+
+void StatisticsWriter::writePath(klee::Path *path) {
+    this->pathsFile << escapeField(this->currentFunctionName) << ","
+                    << this->currentPathNumber++ << ","
+                    << path->size() << ","
+                    << escapeField(path->getPathRepr()) << ","
+                    << path->getSymexTime().toMicroseconds() << "\n";
+}
+
+void StatisticsWriter::endFunction() {
+    this->functionsFile << escapeField(this->currentFunctionName);
+    for (size_t i = 0; i < this->statistics.size(); i++) {
+        this->functionsFile << "," << this->statistics[i]->getValue() - this->functionStartValues[i];
+    }
+    this->functionsFile << "\n";
+
+    // flush after every function, so the results up to a function that blows up are not lost
+    this->functionsFile.flush();
+    this->pathsFile.flush();
+}
+
+void StatisticsWriter::writeHeaders() {
+    this->functionsFile << "Function";
+    for (klee::Statistic *statistic : this->statistics) {
+        this->functionsFile << "," << statistic->getName();
+    }
+    this->functionsFile << "\n";
+
+    this->pathsFile << "Function,Path,Blocks,Repr,SymexTime\n";
+}
+
+std::string StatisticsWriter::escapeField(const std::string &field) {
+    if (field.find_first_of(",\"\n") == std::string::npos) {
+        return field;
+    }
+
+    std::string result = "\"";
+    for (char c : field) {
+        if (c == '"') {
+            result += '"';
+        }
+        result += c;
+    }
+    result += "\"";
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef KLEE_STATISTICSWRITER_H
+#define KLEE_STATISTICSWRITER_H
+
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <klee/Core/FunctionEvaluation.h>
+#include <klee/Statistics/Statistic.h>
+
+
+/// Writes the statistics of a compiler run as csv files into the output directory.
+/// functions.csv contains one row per compiled function with the statistic deltas for that function,
+/// paths.csv contains one row per symbolically executed path.
+class StatisticsWriter {
+private:
+    std::ofstream functionsFile;
+    std::ofstream pathsFile;
+
+    std::vector<klee::Statistic *> statistics;
+    std::vector<uint64_t> functionStartValues;
+
+    std::string currentFunctionName;
+    int currentPathNumber;
+
+public:
+    explicit StatisticsWriter(const std::string &outputDirectory);
+
+    void beginFunction(const std::string &functionName);
+
+    void writePath(klee::Path *path);
+
+    void endFunction();
+
+private:
+    void writeHeaders();
+
+    static std::string escapeField(const std::string &field);
+};
+
+
+#endif //KLEE_STATISTICSWRITER_H
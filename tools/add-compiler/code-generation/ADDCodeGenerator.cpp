@@ -57,33 +57,51 @@ void ADDCodeGenerator::generateForParallelAssignment() {
     }
 
     // create the branch to the next ADD / the end of the function.
-    std::string cutpointName = cutpointBlocks->contains(targetCutpointName) ? targetCutpointName : "end";
-    auto *targetCutpoint = llvm::cast<llvm::BasicBlock>(cutpointBlocks->get(cutpointName));
+    // the ADD of the target cutpoint may not have been generated yet, so the block is created on demand.
+    llvm::BasicBlock *targetCutpoint = getCutpointBlock(targetCutpointName, this->options->getFunction(), cutpointBlocks);
     builder->CreateBr(targetCutpoint);
 }
 
 void ADDCodeGenerator::generateForCondition() {
     llvm::IRBuilder<> *builder = this->options->getBuilder();
 
-    nlohmann::json condition = this->getADDVariable("condition");
-    nlohmann::json trueChild = this->getADDVariable("true-child");
-    nlohmann::json falseChild = this->getADDVariable("false-child");
+    // the children are used in place, the value numbering identifies nodes by their address
+    nlohmann::json *condition = &(*this->add)["condition"];
+    nlohmann::json *trueChild = &(*this->add)["true-child"];
+    nlohmann::json *falseChild = &(*this->add)["false-child"];
 
     // generate code for the condition
     ExpressionTreeCodeGeneratorOptions *conditionOptions = this->createExpressionGeneratorOptions();
-    ExpressionTreeCodeGenerator conditionGenerator(&condition, conditionOptions);
+    ExpressionTreeCodeGenerator conditionGenerator(condition, conditionOptions);
     llvm::Value *compareResult = conditionGenerator.generate();
     delete conditionOptions;
 
+    // compute the subterms both children need before branching, the children inherit them through the cache
+    this->generateHoistedTerms();
+
     // generate code for left and right children.
     // these are ADDs themselves, and code generation can be handled recursively.
-    llvm::BasicBlock *trueBlock = this->generateForChildADD(&trueChild, "then");
-    llvm::BasicBlock *falseBlock = this->generateForChildADD(&falseChild, "else");
+    llvm::BasicBlock *trueBlock = this->generateForChildADD(trueChild, "then");
+    llvm::BasicBlock *falseBlock = this->generateForChildADD(falseChild, "else");
 
     // create branch statement to true and false blocks
     builder->CreateCondBr(compareResult, trueBlock, falseBlock);
 }
 
+void ADDCodeGenerator::generateHoistedTerms() {
+    ADDValueNumbering *valueNumbering = this->options->getValueNumbering();
+    if (valueNumbering == nullptr) {
+        return;
+    }
+
+    for (nlohmann::json *term : valueNumbering->getHoistedTerms(this->add)) {
+        ExpressionTreeCodeGeneratorOptions *generatorOptions = this->createExpressionGeneratorOptions();
+        ExpressionTreeCodeGenerator generator(term, generatorOptions);
+        generator.generate();
+        delete generatorOptions;
+    }
+}
+
 llvm::BasicBlock *
 ADDCodeGenerator::generateForChildADD(nlohmann::json *childADD, const std::string &blockNameAppendix) {
     llvm::LLVMContext *context = this->options->getContext();
@@ -130,10 +148,21 @@ ADDCodeGeneratorOptions *ADDCodeGenerator::createADDGeneratorOptions(
             builder,
             this->options->getCutpointBlocks(),
             this->options->getVariables(),
-            expressionCache
+            expressionCache,
+            this->options->getValueNumbering()
     );
 }
 
+llvm::BasicBlock *ADDCodeGenerator::getCutpointBlock(const std::string &cutpointName, llvm::Function *function, ValueMap *cutpointBlocks) {
+    if (cutpointBlocks->contains(cutpointName)) {
+        return llvm::cast<llvm::BasicBlock>(cutpointBlocks->get(cutpointName));
+    }
+
+    llvm::BasicBlock *block = llvm::BasicBlock::Create(function->getContext(), cutpointName, function);
+    cutpointBlocks->store(cutpointName, block);
+    return block;
+}
+
 bool ADDCodeGenerator::rootNodeIsCondition() {
     return this->add->contains("condition");
 }
@@ -11,6 +11,7 @@
 #include <llvm/IR/IRBuilder.h>
 #include "ValueMap.h"
 #include "ExpressionTreeCodeGenerator.h"
+#include "ADDValueNumbering.h"
 
 
 class ADDCodeGeneratorOptions {
@@ -25,6 +26,8 @@ private:
     ValueMap *variables;
     ValueMap *expressionCache;
 
+    ADDValueNumbering *valueNumbering;
+
 public:
     ADDCodeGeneratorOptions(
             llvm::LLVMContext *context,
@@ -34,7 +37,8 @@ public:
             llvm::IRBuilder<> *irBuilder,
             ValueMap *cutpointBlocks,
             ValueMap *variables,
-            ValueMap *expressionCache
+            ValueMap *expressionCache,
+            ADDValueNumbering *valueNumbering
     ) :
             context(context),
             module(module),
@@ -42,7 +46,8 @@ public:
             irBuilder(irBuilder),
             cutpointBlocks(cutpointBlocks),
             variables(variables),
-            expressionCache(expressionCache) {}
+            expressionCache(expressionCache),
+            valueNumbering(valueNumbering) {}
 
     llvm::LLVMContext *getContext() { return this->context; }
 
@@ -59,6 +64,8 @@ public:
     ValueMap *getVariables() { return this->variables; }
 
     ValueMap *getCache() { return this->expressionCache; }
+
+    ADDValueNumbering *getValueNumbering() { return this->valueNumbering; }
 };
 
 
@@ -77,6 +84,8 @@ public:
 
     void generate();
 
+    static llvm::BasicBlock *getCutpointBlock(const std::string &cutpointName, llvm::Function *function, ValueMap *cutpointBlocks);
+
 private:
     bool rootNodeIsCondition();
 
@@ -84,6 +93,8 @@ private:
 
     void generateForParallelAssignment();
 
+    void generateHoistedTerms();
+
     llvm::BasicBlock *generateForChildADD(nlohmann::json *childADD, const std::string &blockNameAppendix);
 
     ExpressionTreeCodeGeneratorOptions *createExpressionGeneratorOptions();
@@ -0,0 +1,189 @@
+#include "ADDSimplifier.h"
+#include "../ADDCompilerStats.h"
+
+
+ADDSimplifier::ADDSimplifier(klee::FunctionEvaluation *functionEvaluation, klee::Solver *solver) {
+    this->solver = solver;
+
+    int i = 0;
+    for (llvm::Argument &argument : functionEvaluation->getFunction()->args()) {
+        std::string name = "arg" + std::to_string(i++);
+        if (argument.getType()->isIntegerTy()) {
+            this->variableWidths[name] = argument.getType()->getIntegerBitWidth();
+        }
+    }
+
+    for (const auto &variableTypePair : functionEvaluation->getVariableTypeMap()) {
+        if (variableTypePair.second->isIntegerTy()) {
+            this->variableWidths[variableTypePair.first] = variableTypePair.second->getIntegerBitWidth();
+        }
+    }
+}
+
+void ADDSimplifier::simplify(nlohmann::json *decisionDiagram) {
+    this->simplifyNode(decisionDiagram, klee::ConstraintSet());
+}
+
+void ADDSimplifier::simplifyNode(nlohmann::json *node, klee::ConstraintSet constraints) {
+    if (!node->contains("condition")) {
+        return;
+    }
+
+    klee::ref<klee::Expr> condition = this->translate(&(*node)["condition"], klee::Expr::Int64);
+    if (condition.isNull() || condition->getWidth() != klee::Expr::Bool) {
+        this->simplifyNode(&(*node)["true-child"], constraints);
+        this->simplifyNode(&(*node)["false-child"], constraints);
+        return;
+    }
+
+    klee::Solver::Validity validity;
+    if (!this->solver->evaluate(klee::Query(constraints, condition), validity)) {
+        validity = klee::Solver::Unknown;
+    }
+
+    if (validity != klee::Solver::Unknown) {
+        // the test is decided, replace it with the child that is always taken and look at that one instead
+        ++klee::stats::foldedConditions;
+
+        nlohmann::json takenChild = (*node)[validity == klee::Solver::True ? "true-child" : "false-child"];
+        *node = std::move(takenChild);
+
+        this->simplifyNode(node, constraints);
+        return;
+    }
+
+    klee::ConstraintSet trueConstraints(constraints);
+    klee::ConstraintManager(trueConstraints).addConstraint(condition);
+    this->simplifyNode(&(*node)["true-child"], trueConstraints);
+
+    klee::ConstraintSet falseConstraints(constraints);
+    klee::ConstraintManager(falseConstraints).addConstraint(klee::Expr::createIsZero(condition));
+    this->simplifyNode(&(*node)["false-child"], falseConstraints);
+}
+
+klee::ref<klee::Expr> ADDSimplifier::translate(nlohmann::json *expression, klee::Expr::Width literalWidth) {
+    if (expression->is_string()) {
+        std::string value = expression->get<std::string>();
+
+        if (this->variableWidths.count(value)) {
+            return this->getVariable(value);
+        } else if (value == "true" || value == "false") {
+            return klee::ConstantExpr::create(value == "true", klee::Expr::Bool);
+        }
+        return klee::ConstantExpr::create(std::stoull(value), literalWidth);
+    }
+
+    if ((*expression)["type"] == "function-call") {
+        return nullptr;
+    }
+
+    std::string expressionOperator = (*expression)["type"];
+    nlohmann::json *leftChild = &(*expression)["left-child"];
+    nlohmann::json *rightChild = &(*expression)["right-child"];
+
+    // literals take the width of the other operand, like in the generated code
+    klee::ref<klee::Expr> left;
+    klee::ref<klee::Expr> right;
+    if (this->isLiteral(leftChild) && !this->isLiteral(rightChild)) {
+        right = this->translate(rightChild, literalWidth);
+        if (right.isNull()) return nullptr;
+        left = this->translate(leftChild, right->getWidth());
+    } else {
+        left = this->translate(leftChild, literalWidth);
+        if (left.isNull()) return nullptr;
+        right = this->translate(rightChild, left->getWidth());
+    }
+    if (left.isNull() || right.isNull()) {
+        return nullptr;
+    }
+
+    if (left->getWidth() != right->getWidth()) {
+        right = klee::SExtExpr::create(right, left->getWidth());
+    }
+
+    return this->translateOperator(expressionOperator, left, right);
+}
+
+klee::ref<klee::Expr> ADDSimplifier::translateOperator(
+        const std::string &expressionOperator,
+        const klee::ref<klee::Expr> &left,
+        const klee::ref<klee::Expr> &right
+) {
+    // the operators have the meaning of the generated code, see ExpressionTreeCodeGenerator
+    if (expressionOperator == "+") {
+        return klee::AddExpr::create(left, right);
+    } else if (expressionOperator == "-") {
+        return klee::SubExpr::create(left, right);
+    } else if (expressionOperator == "*") {
+        return klee::MulExpr::create(left, right);
+    } else if (expressionOperator == "/") {
+        return klee::SDivExpr::create(left, right);
+    } else if (expressionOperator == "u/") {
+        return klee::UDivExpr::create(left, right);
+    } else if (expressionOperator == "%") {
+        return klee::SRemExpr::create(left, right);
+    } else if (expressionOperator == "u%") {
+        return klee::URemExpr::create(left, right);
+    } else if (expressionOperator == "<<") {
+        return klee::ShlExpr::create(left, right);
+    } else if (expressionOperator == ">>") {
+        return klee::AShrExpr::create(left, right);
+    } else if (expressionOperator == "u>>") {
+        return klee::LShrExpr::create(left, right);
+    } else if (expressionOperator == "&") {
+        return klee::AndExpr::create(left, right);
+    } else if (expressionOperator == "|") {
+        return klee::OrExpr::create(left, right);
+    } else if (expressionOperator == "=") {
+        return klee::EqExpr::create(left, right);
+    } else if (expressionOperator == "<") {
+        return klee::SltExpr::create(left, right);
+    } else if (expressionOperator == "u<") {
+        return klee::UltExpr::create(left, right);
+    } else if (expressionOperator == "<=") {
+        return klee::SleExpr::create(left, right);
+    } else if (expressionOperator == "u<=") {
+        return klee::UleExpr::create(left, right);
+    } else if (expressionOperator == ">") {
+        return klee::SgtExpr::create(left, right);
+    } else if (expressionOperator == "u>") {
+        return klee::UgtExpr::create(left, right);
+    } else if (expressionOperator == ">=") {
+        return klee::SgeExpr::create(left, right);
+    } else if (expressionOperator == "u>=") {
+        return klee::UgeExpr::create(left, right);
+    }
+
+    return nullptr;
+}
+
+klee::ref<klee::Expr> ADDSimplifier::getVariable(const std::string &name) {
+    auto variableIt = this->variableExpressions.find(name);
+    if (variableIt != this->variableExpressions.end()) {
+        return variableIt->second;
+    }
+
+    klee::Expr::Width width = this->variableWidths[name];
+    klee::ref<klee::Expr> result;
+    switch (width) {
+        case klee::Expr::Bool:
+        case klee::Expr::Int8:
+        case klee::Expr::Int16:
+        case klee::Expr::Int32:
+        case klee::Expr::Int64: {
+            const klee::Array *array = this->arrayCache.CreateArray(name, klee::Expr::getMinBytesForWidth(width));
+            result = klee::Expr::createTempRead(array, width);
+            break;
+        }
+        default:
+            // createTempRead only supports the standard widths
+            break;
+    }
+
+    this->variableExpressions[name] = result;
+    return result;
+}
+
+bool ADDSimplifier::isLiteral(nlohmann::json *expression) {
+    return expression->is_string() && !this->variableWidths.count(expression->get<std::string>());
+}
@@ -0,0 +1,54 @@
+#ifndef KLEE_ADDSIMPLIFIER_H
+#define KLEE_ADDSIMPLIFIER_H
+
+
+#include <map>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include <klee/Core/FunctionEvaluation.h>
+#include <klee/Expr/ArrayCache.h>
+#include <klee/Expr/Constraints.h>
+#include <klee/Expr/Expr.h>
+#include <klee/Solver/Solver.h>
+
+
+/// Removes condition nodes from a decision diagram whose outcome is already decided by the conditions taken on
+/// the way to them. The expression trees are translated back into klee expressions over one symbolic array per
+/// variable, and the solver is asked whether the accumulated path condition implies the test or its negation.
+/// Decided nodes are replaced by the child that is always taken.
+///
+/// Conditions that can not be translated (function calls, unsupported widths) are never folded and do not add
+/// to the path condition.
+class ADDSimplifier {
+private:
+    klee::Solver *solver;
+    klee::ArrayCache arrayCache;
+
+    std::map<std::string, klee::Expr::Width> variableWidths;
+    std::map<std::string, klee::ref<klee::Expr>> variableExpressions;
+
+public:
+    ADDSimplifier(klee::FunctionEvaluation *functionEvaluation, klee::Solver *solver);
+
+    void simplify(nlohmann::json *decisionDiagram);
+
+private:
+    void simplifyNode(nlohmann::json *node, klee::ConstraintSet constraints);
+
+    klee::ref<klee::Expr> translate(nlohmann::json *expression, klee::Expr::Width literalWidth);
+
+    klee::ref<klee::Expr> translateOperator(
+            const std::string &expressionOperator,
+            const klee::ref<klee::Expr> &left,
+            const klee::ref<klee::Expr> &right
+    );
+
+    klee::ref<klee::Expr> getVariable(const std::string &name);
+
+    bool isLiteral(nlohmann::json *expression);
+};
+
+
+#endif //KLEE_ADDSIMPLIFIER_H
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <iterator>
+
+#include "ADDValueNumbering.h"
+
+
+ADDValueNumbering::ADDValueNumbering(nlohmann::json *add) {
+    this->analyzeNode(add);
+}
+
+std::vector<nlohmann::json *> ADDValueNumbering::getHoistedTerms(const nlohmann::json *node) {
+    std::vector<nlohmann::json *> result;
+
+    auto hoistedIt = this->hoistedTerms.find(node);
+    if (hoistedIt == this->hoistedTerms.end()) {
+        return result;
+    }
+
+    for (const std::string &number : hoistedIt->second) {
+        result.push_back(&this->terms[number]);
+    }
+    return result;
+}
+
+std::set<std::string> ADDValueNumbering::analyzeNode(nlohmann::json *node) {
+    // returns the value numbers that are computed on every path starting at this node
+    std::set<std::string> computed;
+
+    if (!node->contains("condition")) {
+        for (nlohmann::json &assignment : (*node)["parallel-assignments"]) {
+            this->collectTerms(&assignment["expression"], &computed);
+        }
+        return computed;
+    }
+
+    this->collectTerms(&(*node)["condition"], &computed);
+
+    std::set<std::string> trueComputed = this->analyzeNode(&(*node)["true-child"]);
+    std::set<std::string> falseComputed = this->analyzeNode(&(*node)["false-child"]);
+
+    std::set<std::string> common;
+    std::set_intersection(trueComputed.begin(), trueComputed.end(),
+                          falseComputed.begin(), falseComputed.end(),
+                          std::inserter(common, common.begin()));
+
+    // terms of the condition itself are generated at this node anyway
+    std::vector<std::string> hoisted;
+    std::set_difference(common.begin(), common.end(),
+                        computed.begin(), computed.end(),
+                        std::back_inserter(hoisted));
+
+    if (!hoisted.empty()) {
+        this->hoistedTerms[node] = hoisted;
+    }
+
+    computed.insert(common.begin(), common.end());
+    return computed;
+}
+
+bool ADDValueNumbering::collectTerms(nlohmann::json *expression, std::set<std::string> *numbers) {
+    // returns whether the expression contains a function call
+
+    // leaves are single loads or constants, they are not worth hoisting
+    if (!expression->is_object()) {
+        return false;
+    }
+
+    // function calls are kept where they are, hoisting them would change the order of their side effects
+    if ((*expression)["type"] == "function-call") {
+        for (nlohmann::json &argument : (*expression)["function-arguments"]) {
+            this->collectTerms(&argument, numbers);
+        }
+        return true;
+    }
+
+    bool leftCalls = this->collectTerms(&(*expression)["left-child"], numbers);
+    bool rightCalls = this->collectTerms(&(*expression)["right-child"], numbers);
+
+    // the same holds for every term that contains a call, hoisting it would hoist the call as well
+    if (leftCalls || rightCalls) {
+        return true;
+    }
+
+    std::string number = expression->dump();
+    numbers->insert(number);
+    if (this->terms.find(number) == this->terms.end()) {
+        this->terms[number] = *expression;
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+#ifndef KLEE_ADDVALUENUMBERING_H
+#define KLEE_ADDVALUENUMBERING_H
+
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+
+/// Global value numbering over a decision diagram.
+/// Every expression subterm is numbered by its serialized form, which is also the key of the expression cache.
+/// For every condition node, the subterms that are computed on all paths through both of its children are
+/// collected. Generating them once before the branch lets both children reuse the value from the cache instead
+/// of recomputing it in every leaf. Terms are only hoisted to nodes where they would be computed on every path
+/// anyway, so no path evaluates more than it did before.
+class ADDValueNumbering {
+private:
+    // value number -> expression tree
+    std::map<std::string, nlohmann::json> terms;
+
+    // condition node -> value numbers to generate before branching
+    std::map<const nlohmann::json *, std::vector<std::string>> hoistedTerms;
+
+public:
+    explicit ADDValueNumbering(nlohmann::json *add);
+
+    std::vector<nlohmann::json *> getHoistedTerms(const nlohmann::json *node);
+
+private:
+    std::set<std::string> analyzeNode(nlohmann::json *node);
+
+    bool collectTerms(nlohmann::json *expression, std::set<std::string> *numbers);
+};
+
+
+#endif //KLEE_ADDVALUENUMBERING_H
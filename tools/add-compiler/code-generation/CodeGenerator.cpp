@@ -3,6 +3,8 @@
 //
 
 #include <klee/Core/FunctionEvaluation.h>
+#include <klee/Solver/Common.h>
+#include <klee/Solver/SolverCmdLine.h>
 #include <nlohmann/json.hpp>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Verifier.h>
@@ -11,47 +13,103 @@
 #include "CodeGenerator.h"
 #include "ValueMap.h"
 #include "ADDCodeGenerator.h"
+#include "../ADDCompilerStats.h"
 
 
 CodeGenerator::CodeGenerator(CodeGeneratorOptions *options) {
     this->options = options;
     this->module = new llvm::Module("generated-llvm", *this->options->getContext());
+
+    this->vectorCodeGenerator = nullptr;
+    if (this->options->getVectorWidth() > 1) {
+        this->vectorCodeGenerator = new VectorCodeGenerator(this->module, this->options->getContext(), this->options->getVectorWidth());
+    }
+
+    this->solver = nullptr;
+    this->simplifier = nullptr;
+    if (this->options->shouldSimplifyADDs()) {
+        klee::Solver *coreSolver = klee::createCoreSolver(klee::CoreSolverToUse);
+        if (!coreSolver) {
+            std::cout << "Failed to create core solver for ADD simplification" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        std::string solverLogPrefix = this->options->getOutputDirectory() + "/simplifier-";
+        this->solver = klee::constructSolverChain(
+                coreSolver,
+                solverLogPrefix + "all-queries.smt2",
+                solverLogPrefix + "solver-queries.smt2",
+                solverLogPrefix + "all-queries.kquery",
+                solverLogPrefix + "solver-queries.kquery");
+    }
+}
+
+CodeGenerator::~CodeGenerator() {
+    delete this->vectorCodeGenerator;
+    delete this->simplifier;
+    delete this->solver;
 }
 
 void CodeGenerator::addFunction(llvm::Function *function) {
     this->module->getOrInsertFunction(function->getName(), function->getFunctionType());
 }
 
-void CodeGenerator::generateFunction(klee::FunctionEvaluation *functionEvaluation, nlohmann::json *adds) {
+void CodeGenerator::beginFunction(klee::FunctionEvaluation *functionEvaluation) {
     llvm::LLVMContext *context = this->options->getContext();
     llvm::Function *sourceFunction = functionEvaluation->getFunction();
 
     llvm::FunctionCallee functionCallee = this->module->getOrInsertFunction(sourceFunction->getName(), sourceFunction->getFunctionType());
-    auto *function = llvm::cast<llvm::Function>(functionCallee.getCallee());
-    function->setCallingConv(llvm::CallingConv::C);
+    this->function = llvm::cast<llvm::Function>(functionCallee.getCallee());
+    this->function->setCallingConv(llvm::CallingConv::C);
 
-    ValueMap cutpointBlocks;
-    ValueMap variables;
+    this->cutpointBlocks = ValueMap();
+    this->variables = ValueMap();
 
-    llvm::BasicBlock *mainBlock = llvm::BasicBlock::Create(*context, "main", function);
+    if (this->solver) {
+        delete this->simplifier;
+        this->simplifier = new ADDSimplifier(functionEvaluation, this->solver);
+    }
+
+    llvm::BasicBlock *mainBlock = llvm::BasicBlock::Create(*context, "main", this->function);
     llvm::IRBuilder<> builder(mainBlock);
 
-    this->storeArguments(function, &variables);
-    this->createAllocas(functionEvaluation, &builder, &variables);
-    this->createADDEntryBlocks(adds, function, &cutpointBlocks);
-    this->createBranchToEntryBlock(sourceFunction, &builder, &cutpointBlocks);
-    this->createReturnBlock(functionEvaluation, function, &variables, &cutpointBlocks);
+    this->storeArguments(this->function, &this->variables);
+    this->createAllocas(functionEvaluation, &builder, &this->variables);
+    this->createReturnBlock(functionEvaluation, this->function, &this->variables, &this->cutpointBlocks);
+    this->createBranchToEntryBlock(sourceFunction, &builder, &this->cutpointBlocks);
+
+    if (this->vectorCodeGenerator) {
+        this->vectorCodeGenerator->beginFunction(functionEvaluation);
+    }
+}
+
+void CodeGenerator::generateADD(nlohmann::json *add) {
+    // simplify in place, so the scalar and the vector generation both use the simplified ADD
+    if (this->simplifier) {
+        this->simplifier->simplify(&(*add)["decision-diagram"]);
+    }
+
+    this->generateForADD(add, this->function, &this->variables, &this->cutpointBlocks);
+
+    if (this->vectorCodeGenerator) {
+        this->vectorCodeGenerator->generateADD(add);
+    }
+}
 
+void CodeGenerator::finishFunction() {
+    this->closeUnusedCutpointBlocks(&this->cutpointBlocks);
 
-    for (nlohmann::json add : *adds) {
-        this->generateForADD(&add, function, &variables, &cutpointBlocks);
+    if (this->vectorCodeGenerator) {
+        this->vectorCodeGenerator->finishFunction();
     }
 
     if (!this->verifyModule()) {
-        std::cout << "verify module failed for function " << function->getName().str() << std::endl;
+        std::cout << "verify module failed for function " << this->function->getName().str() << std::endl;
         this->writeModule();
         exit(EXIT_FAILURE);
     }
+
+    klee::stats::generatedInstructions += this->function->getInstructionCount();
 }
 
 void CodeGenerator::writeModule() {
@@ -92,17 +150,7 @@ void CodeGenerator::createBranchToEntryBlock(llvm::Function *sourceFunction, llv
         blockName = std::to_string((long) &entryBlock);
     }
 
-    builder->CreateBr(llvm::cast<llvm::BasicBlock>(cutpointBlocks->get(blockName)));
-}
-
-void CodeGenerator::createADDEntryBlocks(nlohmann::json *adds, llvm::Function *function, ValueMap *cutpointBlocks) {
-    // create the BBs for the start of every ADD, so we can create branches to them
-    for (nlohmann::json add : *adds) {
-        std::string cutpointName = add["start-cutpoint"];
-
-        llvm::BasicBlock *block = llvm::BasicBlock::Create(*this->options->getContext(), cutpointName, function);
-        cutpointBlocks->store(cutpointName, block);
-    }
+    builder->CreateBr(ADDCodeGenerator::getCutpointBlock(blockName, this->function, cutpointBlocks));
 }
 
 void CodeGenerator::createReturnBlock(klee::FunctionEvaluation *functionEvaluation, llvm::Function *function, ValueMap *variables, ValueMap *cutpointBlocks) {
@@ -119,10 +167,11 @@ void CodeGenerator::generateForADD(nlohmann::json *add, llvm::Function *function
     std::string cutpointName = (*add)["start-cutpoint"];
     nlohmann::json decisionDiagram = (*add)["decision-diagram"];
 
-    auto *block = llvm::cast<llvm::BasicBlock>(cutpointBlocks->get(cutpointName));
+    llvm::BasicBlock *block = ADDCodeGenerator::getCutpointBlock(cutpointName, function, cutpointBlocks);
     llvm::IRBuilder<> addBlockBuilder(block);
 
     ValueMap expressionCache;
+    ADDValueNumbering valueNumbering(&decisionDiagram);
 
     ADDCodeGeneratorOptions generatorOptions(
             this->options->getContext(),
@@ -132,12 +181,26 @@ void CodeGenerator::generateForADD(nlohmann::json *add, llvm::Function *function
             &addBlockBuilder,
             cutpointBlocks,
             variables,
-            &expressionCache
+            &expressionCache,
+            &valueNumbering
     );
     ADDCodeGenerator generator(&decisionDiagram, &generatorOptions);
     generator.generate();
 }
 
+void CodeGenerator::closeUnusedCutpointBlocks(ValueMap *cutpointBlocks) {
+    // cutpoints that were branched to but never got an ADD of their own continue at the end of the function
+    auto *returnBlock = llvm::cast<llvm::BasicBlock>(cutpointBlocks->get("end"));
+
+    for (const auto &cutpointPair : *cutpointBlocks) {
+        auto *block = llvm::cast<llvm::BasicBlock>(cutpointPair.second);
+        if (block->getTerminator() == nullptr) {
+            llvm::IRBuilder<> builder(block);
+            builder.CreateBr(returnBlock);
+        }
+    }
+}
+
 bool CodeGenerator::verifyModule() {
     std::error_code error;
     llvm::raw_fd_ostream errorStream(this->options->getOutputDirectory() + "/verify.txt", error);
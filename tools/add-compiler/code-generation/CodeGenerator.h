@@ -7,20 +7,35 @@
 
 
 #include <llvm/IR/Module.h>
+#include <klee/Solver/Solver.h>
 #include "ValueMap.h"
+#include "ADDSimplifier.h"
+#include "VectorCodeGenerator.h"
 
 class CodeGeneratorOptions {
 private:
     llvm::LLVMContext *context;
     std::string outputDirectory;
 
+    // number of lanes of the vectorized function variants, 0 disables them
+    unsigned vectorWidth;
+
+    // remove ADD conditions that are decided by the conditions above them
+    bool simplifyADDs;
+
 public:
-    CodeGeneratorOptions(llvm::LLVMContext *context, std::string outputDirectory)
-            : context(context), outputDirectory(outputDirectory) {}
+    CodeGeneratorOptions(llvm::LLVMContext *context, std::string outputDirectory, unsigned vectorWidth = 0,
+                         bool simplifyADDs = false)
+            : context(context), outputDirectory(outputDirectory), vectorWidth(vectorWidth),
+              simplifyADDs(simplifyADDs) {}
 
     llvm::LLVMContext *getContext() { return this->context; }
 
     std::string getOutputDirectory() { return this->outputDirectory; }
+
+    unsigned getVectorWidth() { return this->vectorWidth; }
+
+    bool shouldSimplifyADDs() { return this->simplifyADDs; }
 };
 
 
@@ -30,12 +45,29 @@ private:
 
     CodeGeneratorOptions *options;
 
+    VectorCodeGenerator *vectorCodeGenerator;
+
+    klee::Solver *solver;
+    ADDSimplifier *simplifier;
+
+    // state of the function that is currently generated
+    llvm::Function *function;
+    ValueMap cutpointBlocks;
+    ValueMap variables;
+
 public:
     explicit CodeGenerator(CodeGeneratorOptions *options);
+    ~CodeGenerator();
 
     void addFunction(llvm::Function *function);
 
-    void generateFunction(klee::FunctionEvaluation *functionEvaluation, nlohmann::json *adds);
+    // incremental generation, used to generate code while the ADDs are still being read.
+    // ADDs may be passed in any order, cutpoint blocks are created as soon as they are referenced.
+    void beginFunction(klee::FunctionEvaluation *functionEvaluation);
+
+    void generateADD(nlohmann::json *add);
+
+    void finishFunction();
 
     void writeModule();
 
@@ -46,12 +78,12 @@ private:
 
     void createBranchToEntryBlock(llvm::Function *sourceFunction, llvm::IRBuilder<> *builder, ValueMap *cutpointBlocks);
 
-    void createADDEntryBlocks(nlohmann::json *adds, llvm::Function *function, ValueMap *cutpointBlocks);
-
     void createReturnBlock(klee::FunctionEvaluation *functionEvaluation, llvm::Function *function, ValueMap *variables, ValueMap *cutpointBlocks);
 
     void generateForADD(nlohmann::json *add, llvm::Function *function, ValueMap *variables, ValueMap *cutpointBlocks);
 
+    void closeUnusedCutpointBlocks(ValueMap *cutpointBlocks);
+
     bool verifyModule();
 };
 
@@ -0,0 +1,423 @@
+#include <iostream>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+
+#include "VectorCodeGenerator.h"
+
+
+VectorCodeGenerator::VectorCodeGenerator(llvm::Module *module, llvm::LLVMContext *context, unsigned width) {
+    this->module = module;
+    this->context = context;
+    this->width = width;
+    this->function = nullptr;
+}
+
+void VectorCodeGenerator::beginFunction(klee::FunctionEvaluation *functionEvaluation) {
+    llvm::Function *sourceFunction = functionEvaluation->getFunction();
+
+    this->function = nullptr;
+    this->functionName = sourceFunction->getName().str() + "_v" + std::to_string(this->width);
+    this->variables = ValueMap();
+    this->variableTypes.clear();
+    this->returnValueName = functionEvaluation->getReturnValueName();
+    this->cutpointIds.clear();
+    this->generatedCutpoints.clear();
+    this->cutpointIds["end"] = 0;
+
+    std::string reason;
+    if (!this->canVectorize(functionEvaluation, &reason)) {
+        std::cout << "[VECTORIZE] skipping " << this->functionName << ": " << reason << std::endl;
+        return;
+    }
+
+    std::vector<llvm::Type *> parameterTypes;
+    for (llvm::Argument &argument : sourceFunction->args()) {
+        parameterTypes.push_back(this->getVectorType(argument.getType()));
+    }
+    llvm::FunctionType *functionType = llvm::FunctionType::get(
+            this->getVectorType(sourceFunction->getReturnType()), parameterTypes, false);
+
+    this->function = llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, this->functionName, this->module);
+    this->function->setCallingConv(llvm::CallingConv::C);
+
+    llvm::BasicBlock *mainBlock = llvm::BasicBlock::Create(*this->context, "main", this->function);
+    llvm::IRBuilder<> builder(mainBlock);
+
+    int i = 0;
+    for (llvm::Value &argument : this->function->args()) {
+        this->variables.store("arg" + std::to_string(i++), &argument);
+    }
+
+    for (const auto &variableTypePair : functionEvaluation->getVariableTypeMap()) {
+        llvm::Type *vectorType = this->getVectorType(variableTypePair.second);
+        this->variables.store(variableTypePair.first, builder.CreateAlloca(vectorType));
+        this->variableTypes[variableTypePair.first] = vectorType;
+    }
+
+    // every lane starts at the entry cutpoint
+    llvm::BasicBlock &entryBlock = sourceFunction->front();
+    std::string entryName = entryBlock.getName().str();
+    if (entryName.empty()) {
+        entryName = std::to_string((long) &entryBlock);
+    }
+
+    llvm::Type *programCounterType = this->getVectorType(llvm::Type::getInt32Ty(*this->context));
+    this->programCounter = builder.CreateAlloca(programCounterType);
+    builder.CreateStore(llvm::ConstantInt::get(programCounterType, this->getCutpointId(entryName)), this->programCounter);
+
+    // loop until every lane has reached the end, each iteration executes the ADD of every lane's cutpoint once
+    this->loopBlock = llvm::BasicBlock::Create(*this->context, "loop", this->function);
+    llvm::BasicBlock *endBlock = llvm::BasicBlock::Create(*this->context, "end", this->function);
+    this->dispatchBlock = llvm::BasicBlock::Create(*this->context, "dispatch", this->function);
+    builder.CreateBr(this->loopBlock);
+
+    llvm::IRBuilder<> loopBuilder(this->loopBlock);
+    this->loopProgramCounter = loopBuilder.CreateLoad(programCounterType, this->programCounter);
+    llvm::Value *activeLanes = loopBuilder.CreateICmpNE(this->loopProgramCounter, llvm::ConstantInt::get(programCounterType, 0));
+    loopBuilder.CreateCondBr(this->generateAnyLane(activeLanes, &loopBuilder), this->dispatchBlock, endBlock);
+
+    llvm::IRBuilder<> endBuilder(endBlock);
+    llvm::Value *returnVariable = this->variables.get(this->returnValueName);
+    endBuilder.CreateRet(endBuilder.CreateLoad(this->variableTypes[this->returnValueName], returnVariable));
+}
+
+void VectorCodeGenerator::generateADD(nlohmann::json *add) {
+    if (this->function == nullptr) {
+        return;
+    }
+
+    std::string cutpointName = (*add)["start-cutpoint"];
+    nlohmann::json *decisionDiagram = &(*add)["decision-diagram"];
+
+    unsigned cutpointId = this->getCutpointId(cutpointName);
+    this->generatedCutpoints.insert(cutpointName);
+
+    // only execute the ADD if at least one lane is located at its cutpoint
+    llvm::IRBuilder<> dispatchBuilder(this->dispatchBlock);
+    llvm::Value *mask = dispatchBuilder.CreateICmpEQ(
+            this->loopProgramCounter, llvm::ConstantInt::get(this->loopProgramCounter->getType(), cutpointId));
+
+    llvm::BasicBlock *addBlock = llvm::BasicBlock::Create(*this->context, cutpointName, this->function);
+    llvm::BasicBlock *nextDispatchBlock = llvm::BasicBlock::Create(*this->context, "dispatch", this->function);
+    dispatchBuilder.CreateCondBr(this->generateAnyLane(mask, &dispatchBuilder), addBlock, nextDispatchBlock);
+
+    llvm::IRBuilder<> builder(addBlock);
+    ValueMap cache;
+    ValueMap newValues;
+    llvm::Value *newProgramCounter = builder.CreateLoad(this->loopProgramCounter->getType(), this->programCounter);
+
+    if (!this->generateForNode(decisionDiagram, mask, &builder, &cache, &newValues, &newProgramCounter)) {
+        this->abandon("function calls can not be vectorized");
+        return;
+    }
+
+    // all right hand sides are computed from the old values, store them only afterwards
+    for (const auto &newValuePair : newValues) {
+        builder.CreateStore(newValuePair.second, this->variables.get(newValuePair.first));
+    }
+    builder.CreateStore(newProgramCounter, this->programCounter);
+    builder.CreateBr(nextDispatchBlock);
+
+    this->dispatchBlock = nextDispatchBlock;
+}
+
+void VectorCodeGenerator::finishFunction() {
+    if (this->function == nullptr) {
+        return;
+    }
+
+    llvm::IRBuilder<> builder(this->dispatchBlock);
+    llvm::Type *programCounterType = this->loopProgramCounter->getType();
+
+    // lanes at cutpoints that never got an ADD continue at the end, like in the scalar function
+    llvm::Value *programCounterValue = nullptr;
+    for (const auto &cutpointPair : this->cutpointIds) {
+        if (cutpointPair.second == 0 || this->generatedCutpoints.count(cutpointPair.first)) {
+            continue;
+        }
+
+        if (programCounterValue == nullptr) {
+            programCounterValue = builder.CreateLoad(programCounterType, this->programCounter);
+        }
+        llvm::Value *mask = builder.CreateICmpEQ(
+                this->loopProgramCounter, llvm::ConstantInt::get(programCounterType, cutpointPair.second));
+        programCounterValue = builder.CreateSelect(mask, llvm::ConstantInt::get(programCounterType, 0), programCounterValue);
+    }
+    if (programCounterValue != nullptr) {
+        builder.CreateStore(programCounterValue, this->programCounter);
+    }
+
+    builder.CreateBr(this->loopBlock);
+    this->function = nullptr;
+}
+
+bool VectorCodeGenerator::canVectorize(klee::FunctionEvaluation *functionEvaluation, std::string *reason) {
+    llvm::Function *sourceFunction = functionEvaluation->getFunction();
+
+    if (!sourceFunction->getReturnType()->isIntegerTy()) {
+        *reason = "return type is not an integer";
+        return false;
+    }
+
+    for (llvm::Argument &argument : sourceFunction->args()) {
+        if (!argument.getType()->isIntegerTy()) {
+            *reason = "argument " + std::to_string(argument.getArgNo()) + " is not an integer";
+            return false;
+        }
+    }
+
+    for (const auto &variableTypePair : functionEvaluation->getVariableTypeMap()) {
+        if (!variableTypePair.second->isIntegerTy()) {
+            *reason = "variable " + variableTypePair.first + " is not an integer";
+            return false;
+        }
+    }
+
+    for (const auto &variableTypePair : functionEvaluation->getVariableTypeMap()) {
+        if (variableTypePair.first == this->returnValueName) {
+            return true;
+        }
+    }
+
+    *reason = "return value is not stored in a variable";
+    return false;
+}
+
+void VectorCodeGenerator::abandon(const std::string &reason) {
+    std::cout << "[VECTORIZE] skipping " << this->functionName << ": " << reason << std::endl;
+
+    this->function->eraseFromParent();
+    this->function = nullptr;
+}
+
+unsigned VectorCodeGenerator::getCutpointId(const std::string &cutpointName) {
+    auto cutpointIt = this->cutpointIds.find(cutpointName);
+    if (cutpointIt != this->cutpointIds.end()) {
+        return cutpointIt->second;
+    }
+
+    unsigned id = this->cutpointIds.size();
+    this->cutpointIds[cutpointName] = id;
+    return id;
+}
+
+bool VectorCodeGenerator::generateForNode(
+        nlohmann::json *node,
+        llvm::Value *mask,
+        llvm::IRBuilder<> *builder,
+        ValueMap *cache,
+        ValueMap *newValues,
+        llvm::Value **newProgramCounter
+) {
+    if (node->contains("condition")) {
+        llvm::Value *condition = this->generateExpression(&(*node)["condition"], nullptr, builder, cache);
+        if (condition == nullptr) {
+            return false;
+        }
+        if (!condition->getType()->getScalarType()->isIntegerTy(1)) {
+            condition = builder->CreateICmpNE(condition, llvm::Constant::getNullValue(condition->getType()));
+        }
+
+        llvm::Value *trueMask = builder->CreateAnd(mask, condition);
+        llvm::Value *falseMask = builder->CreateAnd(mask, builder->CreateNot(condition));
+
+        return this->generateForNode(&(*node)["true-child"], trueMask, builder, cache, newValues, newProgramCounter)
+               && this->generateForNode(&(*node)["false-child"], falseMask, builder, cache, newValues, newProgramCounter);
+    }
+
+    for (nlohmann::json &assignment : (*node)["parallel-assignments"]) {
+        std::string targetVariableName = assignment["variable"];
+        nlohmann::json *expression = &assignment["expression"];
+
+        if (targetVariableName == *expression) {
+            // skip self assignments (var1 = var1)
+            continue;
+        }
+
+        llvm::Type *variableType = this->variableTypes[targetVariableName];
+        llvm::Value *value = this->generateExpression(expression, variableType->getScalarType(), builder, cache);
+        if (value == nullptr) {
+            return false;
+        }
+        if (value->getType() != variableType) {
+            value = builder->CreateIntCast(value, variableType, true);
+        }
+
+        // the leaves of an ADD are disjoint, so each lane takes the value of exactly one leaf
+        llvm::Value *oldValue = newValues->contains(targetVariableName)
+                                ? newValues->get(targetVariableName)
+                                : builder->CreateLoad(variableType, this->variables.get(targetVariableName));
+        newValues->store(targetVariableName, builder->CreateSelect(mask, value, oldValue));
+    }
+
+    std::string targetCutpointName = (*node)["target-cutpoint"];
+    llvm::Value *targetId = llvm::ConstantInt::get((*newProgramCounter)->getType(), this->getCutpointId(targetCutpointName));
+    *newProgramCounter = builder->CreateSelect(mask, targetId, *newProgramCounter);
+
+    return true;
+}
+
+llvm::Value *VectorCodeGenerator::generateExpression(
+        nlohmann::json *expression,
+        llvm::Type *literalType,
+        llvm::IRBuilder<> *builder,
+        ValueMap *cache
+) {
+    if (literalType == nullptr) {
+        literalType = llvm::Type::getInt64Ty(*this->context);
+    }
+
+    // literals are typed by their context, so the type is part of the cache key
+    std::string cacheKey = expression->dump() + "@i" + std::to_string(literalType->getIntegerBitWidth());
+    if (cache->contains(cacheKey)) {
+        return cache->get(cacheKey);
+    }
+
+    llvm::Value *result;
+    if (expression->is_string()) {
+        std::string value = expression->get<std::string>();
+
+        if (this->variables.contains(value)) {
+            llvm::Value *variableValue = this->variables.get(value);
+            result = value[0] == 'a' ? variableValue : builder->CreateLoad(this->variableTypes[value], variableValue);
+        } else if (value == "true" || value == "false") {
+            result = llvm::ConstantInt::get(this->getVectorType(llvm::Type::getInt1Ty(*this->context)), value == "true");
+        } else {
+            result = llvm::ConstantInt::get(this->getVectorType(literalType), std::stoull(value));
+        }
+    } else if ((*expression)["type"] == "function-call") {
+        return nullptr;
+    } else {
+        std::string expressionOperator = (*expression)["type"];
+        nlohmann::json *leftChild = &(*expression)["left-child"];
+        nlohmann::json *rightChild = &(*expression)["right-child"];
+
+        // comparisons do not pass their result type down to their operands
+        bool isComparison = expressionOperator.find_first_of("<>=") != std::string::npos
+                            && expressionOperator != "<<" && expressionOperator != ">>" && expressionOperator != "u>>";
+        llvm::Type *operandType = isComparison ? nullptr : literalType;
+
+        // a literal takes the type of the other operand
+        llvm::Value *leftResult;
+        llvm::Value *rightResult;
+        if (isLiteral(leftChild, &this->variables) && !isLiteral(rightChild, &this->variables)) {
+            rightResult = this->generateExpression(rightChild, operandType, builder, cache);
+            if (rightResult == nullptr) return nullptr;
+            leftResult = this->generateExpression(leftChild, rightResult->getType()->getScalarType(), builder, cache);
+        } else {
+            leftResult = this->generateExpression(leftChild, operandType, builder, cache);
+            if (leftResult == nullptr) return nullptr;
+            rightResult = this->generateExpression(rightChild, leftResult->getType()->getScalarType(), builder, cache);
+        }
+        if (leftResult == nullptr || rightResult == nullptr) {
+            return nullptr;
+        }
+
+        if (leftResult->getType() != rightResult->getType()) {
+            rightResult = builder->CreateIntCast(rightResult, leftResult->getType(), true);
+        }
+
+        result = this->generateOperator(expressionOperator, leftResult, rightResult, builder);
+        if (result == nullptr) {
+            std::cout << "unknown json value during vector expression generation: " << expression->dump(4) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    cache->store(cacheKey, result);
+    return result;
+}
+
+llvm::Value *VectorCodeGenerator::generateOperator(
+        const std::string &expressionOperator,
+        llvm::Value *left,
+        llvm::Value *right,
+        llvm::IRBuilder<> *builder
+) {
+    if (expressionOperator == "+") {
+        return builder->CreateAdd(left, right);
+    } else if (expressionOperator == "-") {
+        return builder->CreateSub(left, right);
+    } else if (expressionOperator == "*") {
+        return builder->CreateMul(left, right);
+    } else if (expressionOperator == "/") {
+        return builder->CreateSDiv(left, this->generateSafeDivisor(expressionOperator, left, right, builder));
+    } else if (expressionOperator == "u/") {
+        return builder->CreateUDiv(left, this->generateSafeDivisor(expressionOperator, left, right, builder));
+    } else if (expressionOperator == "%") {
+        return builder->CreateSRem(left, this->generateSafeDivisor(expressionOperator, left, right, builder));
+    } else if (expressionOperator == "u%") {
+        return builder->CreateURem(left, this->generateSafeDivisor(expressionOperator, left, right, builder));
+    } else if (expressionOperator == "<<") {
+        return builder->CreateShl(left, right);
+    } else if (expressionOperator == ">>") {
+        return builder->CreateAShr(left, right);
+    } else if (expressionOperator == "u>>") {
+        return builder->CreateLShr(left, right);
+    } else if (expressionOperator == "&") {
+        return builder->CreateAnd(left, right);
+    } else if (expressionOperator == "|") {
+        return builder->CreateOr(left, right);
+    } else if (expressionOperator == "=") {
+        return builder->CreateICmpEQ(left, right);
+    } else if (expressionOperator == "<") {
+        return builder->CreateICmpSLT(left, right);
+    } else if (expressionOperator == "u<") {
+        return builder->CreateICmpULT(left, right);
+    } else if (expressionOperator == "<=") {
+        return builder->CreateICmpSLE(left, right);
+    } else if (expressionOperator == "u<=") {
+        return builder->CreateICmpULE(left, right);
+    } else if (expressionOperator == ">") {
+        return builder->CreateICmpSGT(left, right);
+    } else if (expressionOperator == "u>") {
+        return builder->CreateICmpUGT(left, right);
+    } else if (expressionOperator == ">=") {
+        return builder->CreateICmpSGE(left, right);
+    } else if (expressionOperator == "u>=") {
+        return builder->CreateICmpUGE(left, right);
+    }
+
+    return nullptr;
+}
+
+llvm::Value *VectorCodeGenerator::generateSafeDivisor(
+        const std::string &expressionOperator,
+        llvm::Value *left,
+        llvm::Value *right,
+        llvm::IRBuilder<> *builder
+) {
+    // all leaves are computed for all lanes, also for the ones that did not take them.
+    // divisions that would trap are done with a divisor of 1 instead, the results of these lanes are never selected.
+    llvm::Type *type = right->getType();
+    llvm::Value *unsafe = builder->CreateICmpEQ(right, llvm::Constant::getNullValue(type));
+
+    if (expressionOperator == "/" || expressionOperator == "%") {
+        unsigned bitWidth = type->getScalarSizeInBits();
+        llvm::Value *overflow = builder->CreateAnd(
+                builder->CreateICmpEQ(right, llvm::Constant::getAllOnesValue(type)),
+                builder->CreateICmpEQ(left, llvm::ConstantInt::get(type, llvm::APInt::getSignedMinValue(bitWidth))));
+        unsafe = builder->CreateOr(unsafe, overflow);
+    }
+
+    return builder->CreateSelect(unsafe, llvm::ConstantInt::get(type, 1), right);
+}
+
+llvm::Value *VectorCodeGenerator::generateAnyLane(llvm::Value *mask, llvm::IRBuilder<> *builder) {
+    llvm::Type *maskBitsType = llvm::IntegerType::get(*this->context, this->width);
+    llvm::Value *maskBits = builder->CreateBitCast(mask, maskBitsType);
+    return builder->CreateICmpNE(maskBits, llvm::ConstantInt::get(maskBitsType, 0));
+}
+
+llvm::Type *VectorCodeGenerator::getVectorType(llvm::Type *elementType) {
+#if LLVM_VERSION_CODE >= LLVM_VERSION(11, 0)
+    return llvm::FixedVectorType::get(elementType, this->width);
+#else
+    return llvm::VectorType::get(elementType, this->width);
+#endif
+}
+
+bool VectorCodeGenerator::isLiteral(nlohmann::json *expression, ValueMap *variables) {
+    return expression->is_string() && !variables->contains(expression->get<std::string>());
+}
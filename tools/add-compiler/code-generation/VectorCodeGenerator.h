@@ -0,0 +1,86 @@
+#ifndef KLEE_VECTORCODEGENERATOR_H
+#define KLEE_VECTORCODEGENERATOR_H
+
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <nlohmann/json.hpp>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+#include <klee/Config/Version.h>
+#include <klee/Core/FunctionEvaluation.h>
+#include "ValueMap.h"
+
+
+/// Generates an N-lane variant of a compiled function, named <function>_v<N>.
+/// Every argument, variable and the return value become vectors with one lane per independent call.
+/// The ADDs are if-converted: conditions are evaluated as lane masks and the parallel assignments of all leaves
+/// are merged with selects. Lanes may be at different cutpoints, so the function loops over all ADDs and executes
+/// each one for the lanes currently located at its cutpoint, until every lane has reached the end.
+///
+/// Functions that take or return non integer values, or whose ADDs contain function calls, are not vectorized.
+class VectorCodeGenerator {
+private:
+    llvm::Module *module;
+    llvm::LLVMContext *context;
+    unsigned width;
+
+    llvm::Function *function;
+    std::string functionName;
+
+    ValueMap variables;
+    std::map<std::string, llvm::Type *> variableTypes;
+    std::string returnValueName;
+
+    // cutpoint name -> lane program counter value, 0 is the end of the function
+    std::map<std::string, unsigned> cutpointIds;
+    std::set<std::string> generatedCutpoints;
+
+    llvm::Value *programCounter;
+    llvm::Value *loopProgramCounter;
+    llvm::BasicBlock *loopBlock;
+    llvm::BasicBlock *dispatchBlock;
+
+public:
+    VectorCodeGenerator(llvm::Module *module, llvm::LLVMContext *context, unsigned width);
+
+    void beginFunction(klee::FunctionEvaluation *functionEvaluation);
+
+    void generateADD(nlohmann::json *add);
+
+    void finishFunction();
+
+private:
+    bool canVectorize(klee::FunctionEvaluation *functionEvaluation, std::string *reason);
+
+    void abandon(const std::string &reason);
+
+    unsigned getCutpointId(const std::string &cutpointName);
+
+    bool generateForNode(
+            nlohmann::json *node,
+            llvm::Value *mask,
+            llvm::IRBuilder<> *builder,
+            ValueMap *cache,
+            ValueMap *newValues,
+            llvm::Value **newProgramCounter
+    );
+
+    llvm::Value *generateExpression(nlohmann::json *expression, llvm::Type *literalType, llvm::IRBuilder<> *builder, ValueMap *cache);
+
+    llvm::Value *generateOperator(const std::string &expressionOperator, llvm::Value *left, llvm::Value *right, llvm::IRBuilder<> *builder);
+
+    llvm::Value *generateSafeDivisor(const std::string &expressionOperator, llvm::Value *left, llvm::Value *right, llvm::IRBuilder<> *builder);
+
+    llvm::Value *generateAnyLane(llvm::Value *mask, llvm::IRBuilder<> *builder);
+
+    llvm::Type *getVectorType(llvm::Type *elementType);
+
+    static bool isLiteral(nlohmann::json *expression, ValueMap *variables);
+};
+
+
+#endif //KLEE_VECTORCODEGENERATOR_H
@@ -0,0 +1,152 @@
+//===-- ADDSimplifierTest.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "code-generation/ADDSimplifier.h"
+
+#include "klee/Core/FunctionEvaluation.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <memory>
+#include <string>
+
+using namespace klee;
+
+namespace {
+
+/// Simplifies hand-built decision diagrams of a function f(i32, i32) with
+/// numVariables i32 allocas and compares them with the expected diagrams.
+class ADDSimplifierTest : public ::testing::Test {
+protected:
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> sourceModule;
+  llvm::Function *source = nullptr;
+  std::unique_ptr<Solver> solver{createCoreSolver(CoreSolverToUse)};
+
+  void createSource(unsigned numVariables) {
+    sourceModule = std::make_unique<llvm::Module>("source", context);
+    llvm::Type *int32 = llvm::Type::getInt32Ty(context);
+    source = llvm::Function::Create(
+        llvm::FunctionType::get(int32, {int32, int32}, false),
+        llvm::Function::ExternalLinkage, "f", sourceModule.get());
+
+    llvm::IRBuilder<> builder(
+        llvm::BasicBlock::Create(context, "entry", source));
+    for (unsigned i = 0; i < numVariables; ++i)
+      builder.CreateAlloca(int32);
+    builder.CreateRet(llvm::ConstantInt::get(int32, 0));
+  }
+
+  nlohmann::json simplify(nlohmann::json diagram) {
+    FunctionEvaluation evaluation(source);
+    ADDSimplifier simplifier(&evaluation, solver.get());
+    simplifier.simplify(&diagram);
+    return diagram;
+  }
+
+  static nlohmann::json leaf(nlohmann::json assignments,
+                             const std::string &target) {
+    return {{"parallel-assignments", assignments},
+            {"target-cutpoint", target}};
+  }
+
+  static nlohmann::json assign(const std::string &variable,
+                               nlohmann::json expression) {
+    return {{"variable", variable}, {"expression", expression}};
+  }
+
+  static nlohmann::json op(const std::string &type, nlohmann::json left,
+                           nlohmann::json right) {
+    return {{"type", type}, {"left-child", left}, {"right-child", right}};
+  }
+
+  static nlohmann::json branch(nlohmann::json condition,
+                               nlohmann::json trueChild,
+                               nlohmann::json falseChild) {
+    return {{"condition", condition},
+            {"true-child", trueChild},
+            {"false-child", falseChild}};
+  }
+};
+
+TEST_F(ADDSimplifierTest, FoldsImpliedConditions) {
+  createSource(1);
+
+  // arg0 > 5 holds below arg0 > 10 and is open below its negation
+  nlohmann::json large = leaf({assign("var0", "2")}, "end");
+  nlohmann::json medium = leaf({assign("var0", "1")}, "end");
+  nlohmann::json small = leaf({assign("var0", "0")}, "end");
+  nlohmann::json inner = branch(op(">", "arg0", "5"), large, medium);
+  nlohmann::json diagram = branch(
+      op(">", "arg0", "10"), branch(op(">", "arg0", "5"), large, small),
+      inner);
+
+  EXPECT_EQ(simplify(diagram), branch(op(">", "arg0", "10"), large, inner));
+}
+
+TEST_F(ADDSimplifierTest, FoldsContradictingConditions) {
+  createSource(1);
+
+  // arg0 = arg1 can not hold below arg0 < arg1, and neither can
+  // arg1 - arg0 u< 0 in the child that replaces it
+  nlohmann::json zero = leaf({assign("var0", "0")}, "end");
+  nlohmann::json one = leaf({assign("var0", "1")}, "end");
+  nlohmann::json two = leaf({assign("var0", "2")}, "end");
+  nlohmann::json diagram = branch(
+      op("<", "arg0", "arg1"),
+      branch(op("=", "arg0", "arg1"), zero,
+             branch(op("u<", op("-", "arg1", "arg0"), "0"), one, two)),
+      one);
+
+  EXPECT_EQ(simplify(diagram), branch(op("<", "arg0", "arg1"), two, one));
+}
+
+TEST_F(ADDSimplifierTest, UsesTheWidthOfTheOtherOperand) {
+  createSource(1);
+
+  // 4294967295 is -1 as an i32 and var0 > -1 is open below var0 u> 0
+  nlohmann::json positive = leaf({assign("var0", "1")}, "end");
+  nlohmann::json negative = leaf({assign("var0", "0")}, "end");
+  nlohmann::json inner = branch(op(">", "var0", "4294967295"), positive,
+                                negative);
+  nlohmann::json diagram =
+      branch(op("u>", "var0", "0"), inner, leaf({}, "end"));
+
+  EXPECT_EQ(simplify(diagram), diagram);
+
+  // 0 = var0 is decided below var0 u> 0, with the literal on the left
+  diagram = branch(op("u>", "var0", "0"),
+                   branch(op("=", "0", "var0"), negative, positive),
+                   leaf({}, "end"));
+  EXPECT_EQ(simplify(diagram),
+            branch(op("u>", "var0", "0"), positive, leaf({}, "end")));
+}
+
+TEST_F(ADDSimplifierTest, KeepsFunctionCalls) {
+  createSource(1);
+
+  // a condition with a call is neither folded nor assumed below it
+  nlohmann::json call = {{"type", "function-call"},
+                         {"function-name", "g"},
+                         {"function-arguments", {"arg0"}}};
+  nlohmann::json one = leaf({assign("var0", "1")}, "end");
+  nlohmann::json zero = leaf({assign("var0", "0")}, "end");
+  nlohmann::json diagram =
+      branch(op("=", call, "0"), branch(op("=", call, "0"), one, zero), zero);
+
+  EXPECT_EQ(simplify(diagram), diagram);
+}
+
+} // namespace
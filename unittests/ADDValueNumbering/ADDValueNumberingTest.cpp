@@ -0,0 +1,131 @@
+//===-- ADDValueNumberingTest.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "code-generation/ADDValueNumbering.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Numbers a hand-built decision diagram and compares the terms hoisted to
+/// its condition nodes.
+class ADDValueNumberingTest : public ::testing::Test {
+protected:
+  static std::vector<nlohmann::json> hoisted(ADDValueNumbering &numbering,
+                                             const nlohmann::json &node) {
+    std::vector<nlohmann::json> result;
+    for (nlohmann::json *term : numbering.getHoistedTerms(&node))
+      result.push_back(*term);
+    return result;
+  }
+
+  static nlohmann::json leaf(nlohmann::json assignments,
+                             const std::string &target) {
+    return {{"parallel-assignments", assignments},
+            {"target-cutpoint", target}};
+  }
+
+  static nlohmann::json assign(const std::string &variable,
+                               nlohmann::json expression) {
+    return {{"variable", variable}, {"expression", expression}};
+  }
+
+  static nlohmann::json op(const std::string &type, nlohmann::json left,
+                           nlohmann::json right) {
+    return {{"type", type}, {"left-child", left}, {"right-child", right}};
+  }
+
+  static nlohmann::json call(const std::string &function,
+                             nlohmann::json arguments) {
+    return {{"type", "function-call"},
+            {"function-name", function},
+            {"function-arguments", arguments}};
+  }
+
+  static nlohmann::json branch(nlohmann::json condition,
+                               nlohmann::json trueChild,
+                               nlohmann::json falseChild) {
+    return {{"condition", condition},
+            {"true-child", trueChild},
+            {"false-child", falseChild}};
+  }
+};
+
+TEST_F(ADDValueNumberingTest, HoistsTermsOfBothChildren) {
+  // var0 = arg0 < 0 ? arg0 * arg0 + 1 : arg0 * arg0 - 1
+  nlohmann::json square = op("*", "arg0", "arg0");
+  nlohmann::json diagram =
+      branch(op("<", "arg0", "0"),
+             leaf({assign("var0", op("+", square, "1"))}, "end"),
+             leaf({assign("var0", op("-", square, "1"))}, "end"));
+
+  ADDValueNumbering numbering(&diagram);
+  EXPECT_EQ(hoisted(numbering, diagram), std::vector<nlohmann::json>{square});
+}
+
+TEST_F(ADDValueNumberingTest, KeepsTermsOfOneChild) {
+  // only the true side computes arg0 * arg0, hoisting it would make the false
+  // side compute it as well
+  nlohmann::json diagram =
+      branch(op("<", "arg0", "0"),
+             leaf({assign("var0", op("*", "arg0", "arg0"))}, "end"),
+             leaf({assign("var0", op("-", "arg0", "1"))}, "end"));
+
+  ADDValueNumbering numbering(&diagram);
+  EXPECT_TRUE(hoisted(numbering, diagram).empty());
+}
+
+TEST_F(ADDValueNumberingTest, KeepsTermsOfTheCondition) {
+  // arg0 * 2 is generated for the condition before the branch anyway
+  nlohmann::json twice = op("*", "arg0", "2");
+  nlohmann::json diagram =
+      branch(op(">", twice, "0"),
+             leaf({assign("var0", twice)}, "end"),
+             leaf({assign("var0", op("-", "0", twice))}, "end"));
+
+  ADDValueNumbering numbering(&diagram);
+  EXPECT_TRUE(hoisted(numbering, diagram).empty());
+}
+
+TEST_F(ADDValueNumberingTest, HoistsThroughNestedConditions) {
+  // arg1 + 1 is computed on every path, the inner node hoists it over its
+  // children and the outer node over the inner node and the false leaf
+  nlohmann::json term = op("+", "arg1", "1");
+  nlohmann::json diagram = branch(
+      op("<", "arg0", "0"),
+      branch(op("=", "arg0", "arg1"),
+             leaf({assign("var0", op("*", term, "2"))}, "end"),
+             leaf({assign("var0", term)}, "end")),
+      leaf({assign("var0", op("-", term, "arg0"))}, "end"));
+
+  ADDValueNumbering numbering(&diagram);
+  EXPECT_EQ(hoisted(numbering, diagram), std::vector<nlohmann::json>{term});
+  EXPECT_EQ(hoisted(numbering, diagram["true-child"]),
+            std::vector<nlohmann::json>{term});
+  EXPECT_TRUE(hoisted(numbering, diagram["false-child"]).empty());
+}
+
+TEST_F(ADDValueNumberingTest, KeepsFunctionCalls) {
+  // the calls and the terms containing them stay in the leaves, the arguments
+  // are hoisted
+  nlohmann::json argument = op("*", "arg0", "3");
+  nlohmann::json diagram = branch(
+      op("<", "arg0", "0"),
+      leaf({assign("var0", op("+", call("g", {argument}), "1"))}, "end"),
+      leaf({assign("var0", op("+", call("g", {argument}), "1"))}, "end"));
+
+  ADDValueNumbering numbering(&diagram);
+  EXPECT_EQ(hoisted(numbering, diagram),
+            std::vector<nlohmann::json>{argument});
+}
+
+} // namespace
@@ -0,0 +1,213 @@
+//===-- AddressSpaceTest.cpp ----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define KLEE_UNITTEST
+
+#include "gtest/gtest.h"
+
+#include "Core/AddressSpace.h"
+#include "Core/Context.h"
+#include "Core/ExecutionState.h"
+#include "Core/Memory.h"
+#include "Core/MemoryManager.h"
+#include "Core/TimingSolver.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
+#include "klee/Solver/SolverStats.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+class AddressSpaceTest : public ::testing::Test {
+protected:
+  ArrayCache arrayCache;
+  MemoryManager memory{&arrayCache};
+  AddressSpace addressSpace;
+
+  static void SetUpTestCase() { Context::initialize(true, Expr::Int64); }
+
+  /// Binds a concrete, zeroed object of the given size.
+  const MemoryObject *bindConcrete(uint64_t size) {
+    MemoryObject *mo = memory.allocate(size, false, true, nullptr, 8);
+    auto *os = new ObjectState(mo);
+    os->initializeToZero();
+    addressSpace.bindObject(mo, os);
+    return mo;
+  }
+
+  const MemoryObject *bindSymbolic(uint64_t size) {
+    MemoryObject *mo = memory.allocate(size, false, true, nullptr, 8);
+    const Array *array = arrayCache.CreateArray(
+        "sym" + llvm::utostr(mo->id), size);
+    addressSpace.bindObject(mo, new ObjectState(mo, array));
+    return mo;
+  }
+
+  void writePointer(const MemoryObject *mo, unsigned offset,
+                    uint64_t pointer) {
+    ObjectState *os =
+        addressSpace.getWriteable(mo, addressSpace.findObject(mo));
+    os->write64(offset, pointer);
+  }
+
+  static std::vector<const MemoryObject *>
+  objectsOf(const ResolutionList &rl) {
+    std::vector<const MemoryObject *> result;
+    for (const auto &op : rl)
+      result.push_back(op.first);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  static std::vector<const MemoryObject *>
+  sorted(std::vector<const MemoryObject *> objects) {
+    std::sort(objects.begin(), objects.end());
+    return objects;
+  }
+
+  /// The objects a pointer in [lo, hi] can point into.
+  std::vector<const MemoryObject *> overlapping(uint64_t lo, uint64_t hi) {
+    std::vector<const MemoryObject *> result;
+    for (const auto &object : addressSpace.objects) {
+      const MemoryObject *mo = object.first;
+      if (mo->address <= hi && lo < mo->address + mo->size)
+        result.push_back(mo);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  TimingSolver solver{createIndependentSolver(createCachingSolver(
+      createCexCachingSolver(createCoreSolver(CoreSolverToUse))))};
+  ExecutionState state;
+  ref<Expr> pointer = Expr::createTempRead(
+      arrayCache.CreateArray("pointer", 8), Expr::Int64);
+
+  std::vector<const MemoryObject *> bindObjects(unsigned count) {
+    std::vector<const MemoryObject *> objects;
+    for (unsigned i = 0; i < count; ++i)
+      objects.push_back(bindConcrete(16));
+    std::sort(objects.begin(), objects.end(),
+              [](const MemoryObject *a, const MemoryObject *b) {
+                return a->address < b->address;
+              });
+    return objects;
+  }
+
+  /// Constrains the pointer to [lo, hi].
+  void constrain(uint64_t lo, uint64_t hi) {
+    ConstraintManager constraints(state.constraints);
+    constraints.addConstraint(
+        UgeExpr::create(pointer, ConstantExpr::create(lo, Expr::Int64)));
+    constraints.addConstraint(
+        UleExpr::create(pointer, ConstantExpr::create(hi, Expr::Int64)));
+  }
+
+  /// Resolves a pointer in [lo, hi] and expects exactly the objects the
+  /// range overlaps, both from resolve and from the symbolic resolveOne.
+  void expectResolves(uint64_t lo, uint64_t hi) {
+    state.constraints = ConstraintSet();
+    constrain(lo, hi);
+    std::vector<const MemoryObject *> expected = overlapping(lo, hi);
+
+    ResolutionList rl;
+    ASSERT_FALSE(addressSpace.resolve(state, &solver, pointer, rl));
+    EXPECT_EQ(expected, objectsOf(rl)) << "[" << lo << ", " << hi << "]";
+
+    ObjectPair op;
+    bool success;
+    ASSERT_TRUE(addressSpace.resolveOne(state, &solver, pointer, op, success));
+    EXPECT_EQ(!expected.empty(), success) << "[" << lo << ", " << hi << "]";
+    if (success)
+      EXPECT_TRUE(std::count(expected.begin(), expected.end(), op.first));
+  }
+};
+
+} // namespace
+
+/* pointers stored in reachable objects are followed, also one just past an
+   object, objects nothing points to are left out */
+TEST_F(AddressSpaceTest, CollectReachable) {
+  const MemoryObject *a = bindConcrete(32);
+  const MemoryObject *b = bindConcrete(16);
+  const MemoryObject *c = bindConcrete(8);
+  const MemoryObject *unrelated = bindSymbolic(8);
+  (void)unrelated;
+
+  writePointer(a, 8, b->address);
+  writePointer(b, 0, c->address + c->size);
+  // a cycle ends the walk as well
+  writePointer(b, 8, a->address);
+
+  ResolutionList reachable;
+  ASSERT_TRUE(addressSpace.collectReachable({a->address + 4}, reachable));
+  ASSERT_EQ(objectsOf(reachable), sorted({a, b, c}));
+}
+
+/* a symbolic byte in a reachable object fails the collection */
+TEST_F(AddressSpaceTest, CollectReachableSymbolic) {
+  const MemoryObject *a = bindConcrete(16);
+  const MemoryObject *b = bindSymbolic(8);
+  writePointer(a, 0, b->address);
+
+  ResolutionList reachable;
+  ASSERT_FALSE(addressSpace.collectReachable({a->address}, reachable));
+}
+
+/* symbolic pointers resolve to the objects their range covers */
+TEST_F(AddressSpaceTest, ResolveSymbolicManyObjects) {
+  std::vector<const MemoryObject *> objects = bindObjects(64);
+
+  expectResolves(objects[0]->address, objects[0]->address + 15);
+  expectResolves(objects[10]->address + 8, objects[20]->address + 3);
+  expectResolves(objects[50]->address, objects[63]->address + 15);
+  expectResolves(objects[0]->address, objects[63]->address + 15);
+}
+
+/* pointers just below and just past an object */
+TEST_F(AddressSpaceTest, ResolveSymbolicObjectBounds) {
+  std::vector<const MemoryObject *> objects = bindObjects(32);
+
+  for (unsigned i : {0u, 1u, 15u, 30u, 31u}) {
+    uint64_t begin = objects[i]->address;
+    uint64_t end = begin + objects[i]->size;
+    expectResolves(begin - 1, begin - 1);
+    expectResolves(begin - 1, begin);
+    expectResolves(end - 1, end);
+    expectResolves(end, end);
+    expectResolves(end, end + 1);
+  }
+}
+
+/* an expired timeout stops the search for candidates before its first query
+   */
+TEST_F(AddressSpaceTest, ResolveSymbolicTimeout) {
+  std::vector<const MemoryObject *> objects = bindObjects(64);
+  constrain(objects[0]->address, objects[63]->address + 15);
+
+  // the example value and the check of the object it lies in
+  uint64_t queries = stats::queries;
+  ResolutionList rl;
+  ASSERT_TRUE(addressSpace.resolve(state, &solver, pointer, rl, 0,
+                                   time::microseconds(1)));
+  EXPECT_TRUE(rl.empty());
+  EXPECT_LE(stats::queries - queries, 2u);
+
+  queries = stats::queries;
+  ASSERT_FALSE(addressSpace.resolve(state, &solver, pointer, rl));
+  EXPECT_EQ(64u, rl.size());
+  EXPECT_GT(stats::queries - queries, 2u);
+}
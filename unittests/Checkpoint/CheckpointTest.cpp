@@ -0,0 +1,74 @@
+//===-- CheckpointTest.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "Core/Checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace klee;
+
+namespace {
+
+TEST(CheckpointTest, WriteRead) {
+  Checkpoint checkpoint;
+  checkpoint.statistics = {{"Instructions", 12345}, {"Forks", 7}};
+  checkpoint.states = {{1, 0, 1}, {}, {2, 4000000000u}};
+
+  const std::string fileName = "CheckpointTest.checkpoint";
+  ASSERT_TRUE(checkpoint.write(fileName));
+
+  Checkpoint read;
+  ASSERT_TRUE(read.read(fileName));
+  EXPECT_EQ(checkpoint.statistics, read.statistics);
+  EXPECT_EQ(checkpoint.states, read.states);
+
+  std::remove(fileName.c_str());
+}
+
+TEST(CheckpointTest, ReadInvalid) {
+  const std::string fileName = "CheckpointTest.invalid";
+  {
+    std::ofstream out(fileName);
+    out << "klee-checkpoint 1\nstatistics 1\nInstructions 5\nstates 2\n1 0\n";
+  }
+
+  Checkpoint checkpoint;
+  EXPECT_FALSE(checkpoint.read(fileName));
+  EXPECT_FALSE(checkpoint.read(fileName + ".missing"));
+
+  std::remove(fileName.c_str());
+}
+
+TEST(CheckpointTest, Tree) {
+  Checkpoint checkpoint;
+  checkpoint.states = {{1, 0}, {1, 1, 2}, {0}};
+  CheckpointTree tree(checkpoint);
+
+  CheckpointTree::NodeID root = tree.getRoot();
+  ASSERT_FALSE(tree.isLeaf(root));
+  ASSERT_TRUE(tree.hasChild(root, 0));
+  ASSERT_TRUE(tree.hasChild(root, 1));
+  EXPECT_TRUE(tree.isLeaf(tree.getChild(root, 0)));
+
+  CheckpointTree::NodeID node = tree.getChild(root, 1);
+  EXPECT_TRUE(tree.isLeaf(tree.getChild(node, 0)));
+  ASSERT_TRUE(tree.hasChild(node, 1));
+
+  node = tree.getChild(node, 1);
+  EXPECT_FALSE(tree.hasChild(node, 0));
+  EXPECT_FALSE(tree.hasChild(node, 1));
+  ASSERT_TRUE(tree.hasChild(node, 2));
+  EXPECT_TRUE(tree.isLeaf(tree.getChild(node, 2)));
+}
+
+} // namespace
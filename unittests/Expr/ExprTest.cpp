@@ -264,4 +264,22 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+
+TEST(ExprTest, SmallConstantsShared) {
+  ref<ConstantExpr> a = ConstantExpr::create(42, Expr::Int32);
+  ref<ConstantExpr> b = ConstantExpr::create(40, Expr::Int32)->Add(
+      ConstantExpr::create(2, Expr::Int32));
+  EXPECT_EQ(a.get(), b.get());
+
+  // same value, different width
+  ref<ConstantExpr> c = ConstantExpr::create(42, Expr::Int64);
+  EXPECT_NE(a.get(), c.get());
+  EXPECT_EQ(Expr::Int64, c->getWidth());
+
+  // large values are still allocated individually
+  ref<ConstantExpr> d = ConstantExpr::create(1000, Expr::Int32);
+  ref<ConstantExpr> e = ConstantExpr::create(1000, Expr::Int32);
+  EXPECT_NE(d.get(), e.get());
+  EXPECT_EQ(d, e);
+}
 }
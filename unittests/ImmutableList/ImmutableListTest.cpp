@@ -0,0 +1,139 @@
+#include "klee/ADT/ImmutableList.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+std::vector<int> toVector(const ImmutableList<int> &list) {
+  return std::vector<int>(list.begin(), list.end());
+}
+} // namespace
+
+TEST(ImmutableListTest, Empty) {
+  ImmutableList<int> list;
+
+  ASSERT_TRUE(list.empty());
+  ASSERT_EQ(list.size(), 0u);
+  ASSERT_TRUE(list.begin() == list.end());
+}
+
+TEST(ImmutableListTest, PushBack) {
+  ImmutableList<int> list;
+  for (int i = 0; i < 4; ++i)
+    list.push_back(i);
+
+  ASSERT_EQ(list.size(), 4u);
+  ASSERT_EQ(toVector(list), std::vector<int>({0, 1, 2, 3}));
+}
+
+/* appending to a copy must not change the other copies */
+TEST(ImmutableListTest, CopiesAreIndependent) {
+  ImmutableList<int> a;
+  a.push_back(1);
+  a.push_back(2);
+
+  ImmutableList<int> b = a;
+  a.push_back(3);
+  b.push_back(4);
+  b.push_back(5);
+
+  ImmutableList<int> c = b;
+  c.push_back(6);
+
+  ASSERT_EQ(toVector(a), std::vector<int>({1, 2, 3}));
+  ASSERT_EQ(toVector(b), std::vector<int>({1, 2, 4, 5}));
+  ASSERT_EQ(toVector(c), std::vector<int>({1, 2, 4, 5, 6}));
+}
+
+/* once the other copies are gone, the list appends in place again */
+TEST(ImmutableListTest, AppendAfterCopyIsGone) {
+  ImmutableList<int> a;
+  a.push_back(1);
+  {
+    ImmutableList<int> b = a;
+    b.push_back(2);
+  }
+  a.push_back(3);
+
+  ASSERT_EQ(toVector(a), std::vector<int>({1, 3}));
+}
+
+TEST(ImmutableListTest, Equality) {
+  ImmutableList<int> a, b;
+  a.push_back(1);
+  b.push_back(1);
+  ImmutableList<int> c = a;
+
+  ASSERT_TRUE(a == b);
+  ASSERT_TRUE(a == c);
+
+  c.push_back(2);
+  ASSERT_TRUE(a != c);
+}
+
+/* a long chain of chunks must not be destroyed recursively */
+TEST(ImmutableListTest, LongChain) {
+  ImmutableList<int> list;
+  for (int i = 0; i < 100000; ++i) {
+    ImmutableList<int> copy = list;
+    list.push_back(i);
+  }
+
+  ASSERT_EQ(list.size(), 100000u);
+  long sum = 0;
+  for (int value : list)
+    sum += value;
+  ASSERT_EQ(sum, 4999950000L);
+}
+
+/* truncating keeps the prefix shared and does not change the copies */
+TEST(ImmutableListTest, Truncate) {
+  ImmutableList<int> a;
+  for (int i = 0; i < 4; ++i)
+    a.push_back(i);
+  ImmutableList<int> b = a;
+
+  b.truncate(2);
+  b.push_back(7);
+  ASSERT_EQ(toVector(a), std::vector<int>({0, 1, 2, 3}));
+  ASSERT_EQ(toVector(b), std::vector<int>({0, 1, 7}));
+
+  a.truncate(0);
+  ASSERT_TRUE(a.empty());
+  ASSERT_TRUE(a.begin() == a.end());
+  ASSERT_EQ(toVector(b), std::vector<int>({0, 1, 7}));
+}
+
+/* a list that is the only owner of its chunks drops the truncated elements */
+TEST(ImmutableListTest, TruncateInPlace) {
+  ImmutableList<int> list;
+  for (int i = 0; i < 4; ++i)
+    list.push_back(i);
+  ImmutableList<int> copy = list;
+  list.push_back(4);
+  list.push_back(5);
+
+  list.truncate(5);
+  list.push_back(6);
+  list.truncate(3);
+  list.push_back(8);
+  ASSERT_EQ(toVector(list), std::vector<int>({0, 1, 2, 8}));
+  ASSERT_EQ(toVector(copy), std::vector<int>({0, 1, 2, 3}));
+}
+
+/* iterators of a list stay valid while elements are appended in place */
+TEST(ImmutableListTest, IterateWhileAppending) {
+  ImmutableList<int> a;
+  a.push_back(1);
+  ImmutableList<int> b = a;
+  b.push_back(2);
+
+  auto it = b.begin();
+  b.push_back(3);
+  ASSERT_EQ(*it, 1);
+  ASSERT_EQ(*++it, 2);
+  ASSERT_EQ(toVector(b), std::vector<int>({1, 2, 3}));
+}
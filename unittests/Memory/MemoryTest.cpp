@@ -0,0 +1,185 @@
+//===-- MemoryTest.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define KLEE_UNITTEST
+
+#include "gtest/gtest.h"
+
+#include "Core/Context.h"
+#include "Core/Memory.h"
+#include "Core/MemoryManager.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Expr.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+const unsigned ObjectSize = 8;
+
+class ObjectStateTest : public ::testing::Test {
+protected:
+  ArrayCache arrayCache;
+  MemoryManager memory{&arrayCache};
+
+  /// Symbolic bytes used as write and read offsets and as written values.
+  const Array *indices = arrayCache.CreateArray("indices", 2);
+  const Array *values = arrayCache.CreateArray("values", 2);
+
+  static void SetUpTestCase() { Context::initialize(true, Expr::Int64); }
+
+  ref<ObjectState> createObjectState() {
+    MemoryObject *mo = memory.allocate(ObjectSize, false, true, nullptr, 8);
+    ref<ObjectState> os(new ObjectState(mo));
+    os->initializeToZero();
+    return os;
+  }
+
+  const Array *createConstantArray(const std::string &name) {
+    std::vector<ref<ConstantExpr>> contents;
+    for (unsigned i = 0; i < ObjectSize; ++i)
+      contents.push_back(ConstantExpr::create(3 * i, Expr::Int8));
+    return arrayCache.CreateArray(name, ObjectSize, &contents[0],
+                                  &contents[0] + contents.size());
+  }
+
+  static ref<Expr> offset(unsigned i) {
+    return ConstantExpr::create(i, Expr::Int32);
+  }
+
+  static ref<Expr> byte(unsigned value) {
+    return ConstantExpr::create(value, Expr::Int8);
+  }
+
+  ref<Expr> symbolicOffset(unsigned i) const {
+    return ZExtExpr::create(
+        ReadExpr::create(UpdateList(indices, nullptr), offset(i)),
+        Expr::Int32);
+  }
+
+  ref<Expr> symbolicValue(unsigned i) const {
+    return ReadExpr::create(UpdateList(values, nullptr), offset(i));
+  }
+
+  /// Compacts the update list of the object state.
+  static void compact(const ref<ObjectState> &os) {
+    os->nextCompaction = 0;
+    os->compactUpdates();
+  }
+
+  /// Reads every byte and a byte at a symbolic offset from both update lists
+  /// and expects them to evaluate the same for all in-bounds symbolic
+  /// offsets.
+  void expectSameReads(const UpdateList &before, const UpdateList &after) {
+    std::vector<ref<Expr>> reads;
+    for (unsigned i = 0; i < ObjectSize; ++i)
+      reads.push_back(offset(i));
+    reads.push_back(symbolicOffset(1));
+
+    std::vector<const Array *> objects{indices, values};
+    if (!before.root->isConstantArray())
+      objects.push_back(before.root);
+
+    for (unsigned writeIndex = 0; writeIndex < ObjectSize; ++writeIndex) {
+      for (unsigned readIndex = 0; readIndex < ObjectSize; ++readIndex) {
+        std::vector<std::vector<unsigned char>> bindings{
+            {static_cast<unsigned char>(writeIndex),
+             static_cast<unsigned char>(readIndex)},
+            {0xa0, 0xb0}};
+        if (!before.root->isConstantArray()) {
+          std::vector<unsigned char> contents;
+          for (unsigned i = 0; i < ObjectSize; ++i)
+            contents.push_back(0x40 + i);
+          bindings.push_back(contents);
+        }
+        Assignment assignment(objects, bindings);
+
+        for (const auto &index : reads) {
+          ref<Expr> expected =
+              assignment.evaluate(ReadExpr::create(before, index));
+          ref<Expr> actual =
+              assignment.evaluate(ReadExpr::create(after, index));
+          ASSERT_TRUE(isa<ConstantExpr>(expected));
+          EXPECT_EQ(expected, actual)
+              << "write index " << writeIndex << ", read index " << readIndex;
+        }
+      }
+    }
+  }
+};
+
+} // namespace
+
+/* a write at a symbolic index between two writes at the same constant index
+   does not keep the older one alive */
+TEST_F(ObjectStateTest, CompactSymbolicWriteBetweenConstantWrites) {
+  ref<ObjectState> os = createObjectState();
+  UpdateList updates(arrayCache.CreateArray("root", ObjectSize), nullptr);
+  updates.extend(offset(2), byte(0x11));
+  updates.extend(symbolicOffset(0), symbolicValue(0));
+  updates.extend(offset(2), byte(0x22));
+  updates.extend(offset(5), symbolicValue(1));
+  os->updates = updates;
+
+  compact(os);
+
+  EXPECT_EQ(updates.root, os->updates.root);
+  EXPECT_EQ(3u, os->updates.getSize());
+  for (auto *un = os->updates.head.get(); un; un = un->next.get())
+    EXPECT_NE(byte(0x11), un->value);
+  expectSameReads(updates, os->updates);
+}
+
+/* with a constant array as root, the oldest constant writes are folded into
+   a new root up to the first write at a symbolic index */
+TEST_F(ObjectStateTest, CompactConstantArrayRoot) {
+  ref<ObjectState> os = createObjectState();
+  UpdateList updates(createConstantArray("root_c"), nullptr);
+  updates.extend(offset(1), byte(9));
+  updates.extend(offset(4), byte(7));
+  updates.extend(symbolicOffset(0), symbolicValue(0));
+  updates.extend(offset(1), byte(4));
+  updates.extend(offset(6), byte(2));
+  os->updates = updates;
+
+  compact(os);
+
+  const Array *root = os->updates.root;
+  ASSERT_NE(updates.root, root);
+  ASSERT_TRUE(root->isConstantArray());
+  EXPECT_EQ(byte(3), root->constantValues[1]);
+  EXPECT_EQ(byte(7), root->constantValues[4]);
+  EXPECT_EQ(3u, os->updates.getSize());
+  expectSameReads(updates, os->updates);
+}
+
+/* a chain of constant writes is folded completely into the root */
+TEST_F(ObjectStateTest, CompactFoldWholeChain) {
+  ref<ObjectState> os = createObjectState();
+  UpdateList updates(createConstantArray("root_f"), nullptr);
+  updates.extend(offset(0), byte(1));
+  updates.extend(offset(3), byte(2));
+  updates.extend(offset(0), byte(5));
+  updates.extend(offset(7), byte(8));
+  os->updates = updates;
+
+  compact(os);
+
+  const Array *root = os->updates.root;
+  ASSERT_TRUE(root->isConstantArray());
+  EXPECT_EQ(0u, os->updates.getSize());
+  EXPECT_TRUE(os->updates.head.isNull());
+  std::vector<unsigned> expected{5, 3, 6, 2, 12, 15, 18, 8};
+  for (unsigned i = 0; i < ObjectSize; ++i)
+    EXPECT_EQ(byte(expected[i]), root->constantValues[i]);
+  expectSameReads(updates, os->updates);
+}
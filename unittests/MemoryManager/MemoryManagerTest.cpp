@@ -0,0 +1,172 @@
+//===-- MemoryManagerTest.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define KLEE_UNITTEST
+
+#include "gtest/gtest.h"
+
+#include "Core/Context.h"
+#include "Core/Memory.h"
+#include "Core/MemoryManager.h"
+
+#include "klee/Expr/ArrayCache.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+const unsigned Quarantine = 4;
+
+/// Allocates deterministically with a quarantine of Quarantine objects.
+class MemoryManagerTest : public ::testing::Test {
+protected:
+  ArrayCache arrayCache;
+  std::unique_ptr<MemoryManager> memory;
+
+  static void SetUpTestCase() { Context::initialize(true, Expr::Int64); }
+
+  template <typename T> static void setOption(const char *name, T value) {
+    llvm::StringMap<llvm::cl::Option *> &options =
+        llvm::cl::getRegisteredOptions();
+    ASSERT_TRUE(options.count(name)) << name;
+    static_cast<llvm::cl::opt<T> *>(options[name])->setValue(value);
+  }
+
+  void SetUp() override {
+    setOption("allocate-determ", true);
+    setOption("allocate-determ-size", 1u);
+    setOption("allocate-determ-quarantine", Quarantine);
+    memory = std::make_unique<MemoryManager>(&arrayCache);
+  }
+
+  void TearDown() override {
+    memory.reset();
+    setOption("allocate-determ", false);
+    setOption("allocate-determ-size", 100u);
+    setOption("allocate-determ-quarantine", 1024u);
+  }
+
+  uint64_t allocate(uint64_t size, size_t alignment = 8) {
+    MemoryObject *mo = memory->allocate(size, false, true, nullptr, alignment);
+    EXPECT_TRUE(mo);
+    if (!mo)
+      return 0;
+    objects.push_back(mo);
+    return mo->address;
+  }
+
+  void free(uint64_t address) {
+    auto it = std::find_if(objects.begin(), objects.end(),
+                           [=](const MemoryObject *mo) {
+                             return mo->address == address;
+                           });
+    ASSERT_NE(it, objects.end());
+    delete *it;
+    objects.erase(it);
+  }
+
+  /// Allocates and frees objects of several sizes and alignments.
+  std::vector<uint64_t> runSequence() {
+    std::vector<uint64_t> addresses;
+    for (unsigned i = 0; i < 32; ++i) {
+      addresses.push_back(allocate(8 + 24 * (i % 5), i % 3 ? 8 : 64));
+      if (i % 2)
+        free(addresses[i - 1]);
+    }
+    for (unsigned i = 0; i < 8; ++i)
+      addresses.push_back(allocate(8 + 24 * (i % 5), 16));
+    for (MemoryObject *mo : objects)
+      delete mo;
+    objects.clear();
+    return addresses;
+  }
+
+private:
+  std::vector<MemoryObject *> objects;
+};
+
+} // namespace
+
+/* freed slots are reused in the order they leave the quarantine, the slots
+   still in it are not */
+TEST_F(MemoryManagerTest, QuarantineDelaysReuse) {
+  std::vector<uint64_t> freed;
+  for (unsigned i = 0; i < 2 * Quarantine; ++i)
+    freed.push_back(allocate(24));
+  uint64_t other = allocate(100);
+  for (uint64_t address : freed)
+    free(address);
+  free(other);
+
+  // the 128-byte slot is still quarantined, the first 32-byte slots are not
+  std::vector<uint64_t> reused;
+  for (unsigned i = 0; i < Quarantine - 1; ++i)
+    reused.push_back(allocate(20));
+  EXPECT_EQ(reused, std::vector<uint64_t>(freed.begin(),
+                                          freed.begin() + Quarantine - 1));
+  EXPECT_EQ(freed[Quarantine - 1], allocate(32));
+  EXPECT_EQ(freed[Quarantine], allocate(17));
+  uint64_t fresh = allocate(24);
+  EXPECT_EQ(std::count(freed.begin(), freed.end(), fresh), 0);
+  EXPECT_NE(other, allocate(100));
+
+  // freeing another object pushes the next one out of the quarantine
+  free(fresh);
+  EXPECT_EQ(freed[Quarantine + 1], allocate(24));
+}
+
+/* a free slot is only reused for an allocation it is aligned for */
+TEST_F(MemoryManagerTest, ReuseKeepsAlignment) {
+  std::vector<uint64_t> freed;
+  for (unsigned i = 0; i < Quarantine + 6; ++i)
+    freed.push_back(allocate(32, 16));
+  for (uint64_t address : freed)
+    free(address);
+  std::vector<uint64_t> available(freed.begin(), freed.begin() + 6);
+
+  for (size_t alignment : {64u, 32u, 64u}) {
+    uint64_t address = allocate(32, alignment);
+    EXPECT_EQ(address % alignment, 0u) << alignment;
+
+    auto it = std::find_if(available.begin(), available.end(),
+                           [=](uint64_t slot) {
+                             return slot % alignment == 0;
+                           });
+    if (it == available.end()) {
+      EXPECT_EQ(std::count(freed.begin(), freed.end(), address), 0);
+    } else {
+      EXPECT_EQ(*it, address) << alignment;
+      available.erase(it);
+    }
+  }
+
+  // the remaining slots follow in order
+  for (uint64_t slot : available)
+    EXPECT_EQ(slot, allocate(32, 8));
+}
+
+/* the same allocations and frees give the same addresses in another run */
+TEST_F(MemoryManagerTest, ReuseIsDeterministic) {
+  std::vector<uint64_t> first = runSequence();
+  // some slots were reused
+  EXPECT_LT(std::set<uint64_t>(first.begin(), first.end()).size(),
+            first.size());
+
+  memory.reset();
+  memory = std::make_unique<MemoryManager>(&arrayCache);
+  std::vector<uint64_t> second = runSequence();
+
+  EXPECT_EQ(first, second);
+}
@@ -0,0 +1,120 @@
+#include "Core/MemoryPool.h"
+
+#include "klee/System/MemoryUsage.h"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+const std::size_t BlockSize = 64;
+const std::size_t NumBlocks = 100000;
+
+/// The vectors are reserved up front, so they do not show up in the malloc
+/// usage measured between allocating and releasing the blocks.
+void allocateBlocks(std::vector<void *> &blocks, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i)
+    blocks.push_back(MemoryPool::allocate(BlockSize));
+}
+
+void releaseBlocks(std::vector<void *> &blocks) {
+  for (void *block : blocks)
+    MemoryPool::deallocate(block, BlockSize);
+  blocks.clear();
+}
+
+std::size_t getMallocUsage() { return util::GetTotalMallocUsage(); }
+} // namespace
+
+/* released blocks must lower the malloc usage again, the memory limit
+   relies on it */
+TEST(MemoryPoolTest, FreeSlabsAreReleased) {
+  std::vector<void *> blocks;
+  blocks.reserve(NumBlocks);
+  MemoryPool::trim();
+  std::size_t before = getMallocUsage();
+
+  allocateBlocks(blocks, NumBlocks);
+  std::size_t growth = getMallocUsage() - before;
+  EXPECT_GE(growth, NumBlocks * BlockSize);
+
+  // all but one slab of the class go back right away
+  releaseBlocks(blocks);
+  EXPECT_LE(getMallocUsage(), before + growth / 20);
+}
+
+TEST(MemoryPoolTest, BlocksAreReused) {
+  void *block = MemoryPool::allocate(BlockSize);
+  MemoryPool::deallocate(block, BlockSize);
+  EXPECT_EQ(MemoryPool::allocate(BlockSize), block);
+  MemoryPool::deallocate(block, BlockSize);
+}
+
+TEST(MemoryPoolTest, ReleaseOnAnotherThread) {
+  std::vector<void *> blocks;
+  blocks.reserve(NumBlocks);
+  std::thread([] {}).join();
+  MemoryPool::trim();
+  std::size_t before = getMallocUsage();
+
+  // the blocks of this thread are released by a worker and picked up again
+  // before a new slab is needed
+  allocateBlocks(blocks, NumBlocks);
+  std::size_t growth = getMallocUsage() - before;
+  std::thread worker([&blocks] { releaseBlocks(blocks); });
+  worker.join();
+  allocateBlocks(blocks, NumBlocks);
+  EXPECT_LE(getMallocUsage(), before + growth + growth / 20);
+
+  releaseBlocks(blocks);
+  EXPECT_LE(getMallocUsage(), before + growth / 20);
+}
+
+TEST(MemoryPoolTest, BlocksOutliveTheirThread) {
+  std::vector<void *> blocks;
+  blocks.reserve(NumBlocks);
+  std::thread([] {}).join();
+  MemoryPool::trim();
+  std::size_t before = getMallocUsage();
+
+  std::thread worker([&blocks] { allocateBlocks(blocks, NumBlocks); });
+  worker.join();
+  std::size_t growth = getMallocUsage() - before;
+  EXPECT_GE(growth, NumBlocks * BlockSize);
+
+  // the slabs of the finished thread go away with their last block
+  releaseBlocks(blocks);
+  EXPECT_LE(getMallocUsage(), before + growth / 20);
+}
+
+TEST(MemoryPoolTest, ConcurrentThreads) {
+  std::vector<std::vector<void *>> blocks(4);
+  for (std::vector<void *> &threadBlocks : blocks)
+    threadBlocks.reserve(NumBlocks / 10);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < blocks.size(); ++i) {
+    workers.emplace_back([&blocks, i] {
+      for (unsigned round = 0; round < 10; ++round) {
+        allocateBlocks(blocks[i], NumBlocks / 10);
+        releaseBlocks(blocks[i]);
+      }
+      allocateBlocks(blocks[i], NumBlocks / 10);
+    });
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+
+  // every thread releases the blocks of another one
+  workers.clear();
+  for (unsigned i = 0; i < blocks.size(); ++i) {
+    workers.emplace_back([&blocks, i] {
+      releaseBlocks(blocks[(i + 1) % blocks.size()]);
+    });
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+}
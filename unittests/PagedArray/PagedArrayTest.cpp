@@ -0,0 +1,86 @@
+#include "klee/ADT/PagedArray.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+typedef PagedArray<int, 4> SmallPagedArray;
+
+std::vector<int> toVector(const SmallPagedArray &array) {
+  std::vector<int> result(array.size());
+  array.copyTo(result.data());
+  return result;
+}
+} // namespace
+
+TEST(PagedArrayTest, Fill) {
+  SmallPagedArray array(10, 7);
+
+  ASSERT_EQ(array.size(), 10u);
+  ASSERT_EQ(toVector(array), std::vector<int>(10, 7));
+
+  array.fill(3);
+  ASSERT_EQ(toVector(array), std::vector<int>(10, 3));
+}
+
+/* pages shared by a fill must be copied before the first write */
+TEST(PagedArrayTest, WriteToSharedFillPage) {
+  SmallPagedArray array(12);
+  array.set(5, 1);
+
+  std::vector<int> expected(12, 0);
+  expected[5] = 1;
+  ASSERT_EQ(toVector(array), expected);
+}
+
+/* writing to a copy must not change the other copies */
+TEST(PagedArrayTest, CopiesAreIndependent) {
+  SmallPagedArray a(10);
+  for (unsigned i = 0; i < a.size(); ++i)
+    a.set(i, i);
+
+  SmallPagedArray b = a;
+  a.set(1, 100);
+  b.set(9, 200);
+
+  ASSERT_EQ(a[1], 100);
+  ASSERT_EQ(a[9], 9);
+  ASSERT_EQ(b[1], 1);
+  ASSERT_EQ(b[9], 200);
+}
+
+TEST(PagedArrayTest, EqualsAndAssign) {
+  SmallPagedArray array(6, 1);
+  std::vector<int> values(6, 1);
+  ASSERT_TRUE(array.equals(values.data()));
+
+  values[4] = 2;
+  ASSERT_FALSE(array.equals(values.data()));
+
+  SmallPagedArray copy = array;
+  array.assign(values.data());
+  ASSERT_TRUE(array.equals(values.data()));
+  ASSERT_EQ(copy[4], 1);
+}
+
+TEST(PagedArrayTest, PackedArray) {
+  PagedPackedArray<2, 64> a(100, 3);
+  PagedPackedArray<2, 64> b = a;
+
+  a.set(70, 3);
+  a.set(3, 1);
+  a.set(4, 2);
+
+  ASSERT_EQ(a.get(3), 1u);
+  ASSERT_EQ(a.get(4), 2u);
+  ASSERT_EQ(a.get(70), 3u);
+  ASSERT_EQ(b.get(3), 3u);
+
+  b.set(99, 0);
+  ASSERT_EQ(b.get(99), 0u);
+  ASSERT_EQ(a.get(99), 3u);
+}
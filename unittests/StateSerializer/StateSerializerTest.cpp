@@ -0,0 +1,204 @@
+//===-- StateSerializerTest.cpp -------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define KLEE_UNITTEST
+
+#include "gtest/gtest.h"
+
+#include "Core/AddressSpace.h"
+#include "Core/Context.h"
+#include "Core/ExecutionState.h"
+#include "Core/Memory.h"
+#include "Core/MemoryManager.h"
+#include "Core/StateSerializer.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Module/InstructionInfoTable.h"
+#include "klee/Module/KModule.h"
+
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <memory>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// f(a, b) = a + b, its frames have four registers.
+struct TestFunction {
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> module;
+  KModule kmodule;
+  std::unique_ptr<KFunction> kf;
+
+  TestFunction() : module(new llvm::Module("test", context)) {
+    llvm::Type *int32 = llvm::Type::getInt32Ty(context);
+    llvm::Function *f = llvm::Function::Create(
+        llvm::FunctionType::get(int32, {int32, int32}, false),
+        llvm::Function::ExternalLinkage, "f", module.get());
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", f));
+    builder.CreateRet(builder.CreateAdd(f->getArg(0), f->getArg(1)));
+
+    kmodule.targetData.reset(new llvm::DataLayout(module.get()));
+    kf.reset(new KFunction(f, &kmodule));
+  }
+};
+
+/// Everything of the state the serializer writes out: the registers and
+/// their segments, every byte of the object and a read at a symbolic offset,
+/// which goes through the update list, and the constraints.
+std::vector<ref<Expr>> snapshot(const ExecutionState &state,
+                                const MemoryObject *mo, ref<Expr> offset) {
+  std::vector<ref<Expr>> result;
+  for (const StackFrame &sf : state.stack)
+    for (unsigned i = 0; i < sf.kf->numRegisters; ++i) {
+      result.push_back(sf.getLocal(i).value);
+      result.push_back(sf.getSegment(i));
+    }
+
+  const ObjectState *os = state.addressSpace.findObject(mo);
+  EXPECT_NE(os, nullptr);
+  if (os) {
+    for (unsigned i = 0; i < os->size; ++i)
+      result.push_back(os->read8(i));
+    result.push_back(os->read(offset, Expr::Int8));
+  }
+
+  for (const auto &constraint : state.constraints)
+    result.push_back(constraint);
+  return result;
+}
+
+void expectSame(const std::vector<ref<Expr>> &expected,
+                const std::vector<ref<Expr>> &actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (unsigned i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(expected[i].isNull(), actual[i].isNull()) << "expression " << i;
+    if (!expected[i].isNull())
+      EXPECT_EQ(expected[i], actual[i]) << "expression " << i;
+  }
+}
+
+class StateSerializerTest : public ::testing::Test {
+protected:
+  static void SetUpTestCase() { Context::initialize(true, Expr::Int64); }
+};
+
+TEST_F(StateSerializerTest, SpillRestore) {
+  TestFunction function;
+  ArrayCache arrayCache;
+  MemoryManager memory(&arrayCache);
+  StateSerializer serializer("StateSerializerTest.spill");
+
+  const Array *array = arrayCache.CreateArray("input", 4);
+  ref<Expr> x = Expr::createTempRead(array, Expr::Int32);
+
+  ExecutionState state(function.kf.get());
+
+  // bound before branching, so the object state is shared with the branch
+  MemoryObject *sharedMo = memory.allocate(4, false, true, nullptr, 8);
+  auto *sharedOs = new ObjectState(sharedMo);
+  sharedOs->write32(0, 0x12345678);
+  state.addressSpace.bindObject(sharedMo, sharedOs);
+
+  std::unique_ptr<ExecutionState> branch(state.branch());
+
+  // symbolic registers, the frame is copied from the branch's on the write
+  StackFrame &sf = state.stack.back();
+  sf.getWritableLocal(0).value = x;
+  sf.getWritableLocal(2).value =
+      AddExpr::create(x, ConstantExpr::create(1, Expr::Int32));
+  sf.setSegment(2, sharedMo->getBaseExpr());
+  EXPECT_TRUE(branch->stack.back().getSegment(2).isNull());
+
+  // concrete, symbolic and flushed bytes, the write at a symbolic offset
+  // goes to the update list
+  MemoryObject *mo = memory.allocate(16, true, false, nullptr, 8);
+  auto *os = new ObjectState(mo);
+  os->initializeToZero();
+  os->write8(1, 42);
+  os->write(8, x);
+  ref<Expr> offset = AndExpr::create(x, ConstantExpr::create(7, Expr::Int32));
+  os->write(offset, ConstantExpr::create(0xAB, Expr::Int8));
+  os->write(12, AddExpr::create(x, x));
+  state.addressSpace.bindObject(mo, os);
+
+  state.addConstraint(UltExpr::create(x, ConstantExpr::create(100, Expr::Int32)));
+  state.addConstraint(
+      UltExpr::create(ConstantExpr::create(10, Expr::Int32), x));
+
+  ref<Expr> probe =
+      AndExpr::create(LShrExpr::create(x, ConstantExpr::create(8, Expr::Int32)),
+                      ConstantExpr::create(15, Expr::Int32));
+  std::vector<ref<Expr>> before = snapshot(state, mo, probe);
+
+  ASSERT_TRUE(serializer.spill(state));
+  EXPECT_TRUE(serializer.isSpilled(state));
+  EXPECT_EQ(serializer.getNumSpilled(), 1u);
+
+  // only the parts owned by the state are released
+  EXPECT_EQ(state.addressSpace.findObject(mo), nullptr);
+  EXPECT_EQ(state.addressSpace.findObject(sharedMo), sharedOs);
+  EXPECT_EQ(branch->addressSpace.findObject(sharedMo), sharedOs);
+  EXPECT_TRUE(state.constraints.empty());
+
+  serializer.restore(state);
+  EXPECT_FALSE(serializer.isSpilled(state));
+  EXPECT_EQ(serializer.getNumSpilled(), 0u);
+
+  expectSame(before, snapshot(state, mo, probe));
+  EXPECT_EQ(state.addressSpace.findObject(sharedMo), sharedOs);
+
+  // the restored object state belongs to the state again
+  const ObjectState *restored = state.addressSpace.findObject(mo);
+  ASSERT_NE(restored, nullptr);
+  ObjectState *writeable = state.addressSpace.getWriteable(mo, restored);
+  EXPECT_EQ(writeable, restored);
+  writeable->write8(0, 7);
+  EXPECT_EQ(writeable->read8(0), ConstantExpr::create(7, Expr::Int8));
+}
+
+TEST_F(StateSerializerTest, SharedFramesStayInMemory) {
+  TestFunction function;
+  ArrayCache arrayCache;
+  MemoryManager memory(&arrayCache);
+  StateSerializer serializer("StateSerializerTest.shared");
+
+  const Array *array = arrayCache.CreateArray("input", 4);
+  ref<Expr> x = Expr::createTempRead(array, Expr::Int32);
+
+  ExecutionState state(function.kf.get());
+  state.stack.back().getWritableLocal(1).value = x;
+  state.stack.back().setSegment(1, ConstantExpr::create(0x1000, Expr::Int64));
+  std::unique_ptr<ExecutionState> branch(state.branch());
+
+  MemoryObject *mo = memory.allocate(4, true, false, nullptr, 8);
+  auto *os = new ObjectState(mo);
+  os->write(0, x);
+  state.addressSpace.bindObject(mo, os);
+
+  ref<Expr> probe = ConstantExpr::create(2, Expr::Int32);
+  std::vector<ref<Expr>> before = snapshot(state, mo, probe);
+
+  ASSERT_TRUE(serializer.spill(state));
+  // the registers are still shared with the branch and readable
+  EXPECT_EQ(state.stack.back().getLocal(1).value, x);
+  EXPECT_EQ(branch->stack.back().getLocal(1).value, x);
+  EXPECT_EQ(state.stack.back().getSegment(1),
+            branch->stack.back().getSegment(1));
+
+  serializer.restore(state);
+  expectSame(before, snapshot(state, mo, probe));
+}
+
+} // namespace
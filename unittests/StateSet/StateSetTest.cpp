@@ -0,0 +1,65 @@
+//===-- StateSetTest.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define KLEE_UNITTEST
+
+#include "gtest/gtest.h"
+
+#include "Core/ExecutionState.h"
+#include "Core/StateSet.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+TEST(StateSetTest, InsertErase) {
+  ExecutionState es0, es1, es2;
+  StateSet states;
+  EXPECT_TRUE(states.empty());
+
+  EXPECT_TRUE(states.insert(&es0));
+  EXPECT_TRUE(states.insert(&es1));
+  EXPECT_TRUE(states.insert(&es2));
+  EXPECT_FALSE(states.insert(&es1));
+  EXPECT_EQ(states.size(), 3u);
+  EXPECT_EQ(states.count(&es1), 1u);
+
+  EXPECT_TRUE(states.erase(&es0));
+  EXPECT_FALSE(states.erase(&es0));
+  EXPECT_EQ(states.size(), 2u);
+  EXPECT_EQ(states.count(&es0), 0u);
+  EXPECT_EQ(states.count(&es1), 1u);
+  EXPECT_EQ(states.count(&es2), 1u);
+
+  EXPECT_TRUE(states.erase(&es2));
+  EXPECT_TRUE(states.erase(&es1));
+  EXPECT_TRUE(states.empty());
+}
+
+TEST(StateSetTest, IterationOrder) {
+  ExecutionState es0, es1, es2, es3;
+  StateSet states;
+  states.insert(&es0);
+  states.insert(&es1);
+  states.insert(&es2);
+  states.insert(&es3);
+
+  // the last state takes the place of a removed one
+  states.erase(&es1);
+  std::vector<ExecutionState *> order(states.begin(), states.end());
+  EXPECT_EQ(order, (std::vector<ExecutionState *>{&es0, &es3, &es2}));
+
+  states.erase(&es2);
+  states.insert(&es1);
+  order.assign(states.begin(), states.end());
+  EXPECT_EQ(order, (std::vector<ExecutionState *>{&es0, &es3, &es1}));
+}
+
+}
@@ -0,0 +1,212 @@
+//===-- VectorCodeGeneratorTest.cpp ---------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "code-generation/VectorCodeGenerator.h"
+
+#include "klee/Core/FunctionEvaluation.h"
+
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdint>
+#include <memory>
+
+using namespace klee;
+
+namespace {
+
+const unsigned Width = 4;
+
+/// Generates <name>_v4 from the given ADDs and runs it on one vector of
+/// arguments. The scalar source function takes an i32, returns var0 and has
+/// numVariables i32 allocas, which is all the generator looks at.
+class VectorCodeGeneratorTest : public ::testing::Test {
+protected:
+  llvm::LLVMContext context;
+  std::unique_ptr<llvm::Module> sourceModule;
+  llvm::Function *source = nullptr;
+
+  static void SetUpTestCase() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  }
+
+  void createSource(unsigned numVariables) {
+    sourceModule = std::make_unique<llvm::Module>("source", context);
+    llvm::Type *int32 = llvm::Type::getInt32Ty(context);
+    source = llvm::Function::Create(
+        llvm::FunctionType::get(int32, {int32}, false),
+        llvm::Function::ExternalLinkage, "f", sourceModule.get());
+
+    llvm::IRBuilder<> builder(
+        llvm::BasicBlock::Create(context, "entry", source));
+    for (unsigned i = 0; i < numVariables; ++i)
+      builder.CreateAlloca(int32);
+    builder.CreateRet(llvm::ConstantInt::get(int32, 0));
+  }
+
+  /// \return false if the function was not vectorized
+  bool run(const std::vector<nlohmann::json> &adds,
+           const int32_t (&arguments)[Width], int32_t (&results)[Width]) {
+    FunctionEvaluation evaluation(source);
+    evaluation.setReturnValueName("var0");
+
+    auto module = std::make_unique<llvm::Module>("vector", context);
+    VectorCodeGenerator generator(module.get(), &context, Width);
+    generator.beginFunction(&evaluation);
+    for (nlohmann::json add : adds)
+      generator.generateADD(&add);
+    generator.finishFunction();
+
+    llvm::Function *vectorFunction = module->getFunction("f_v4");
+    if (!vectorFunction)
+      return false;
+
+    // void run(<4 x i32> *arguments, <4 x i32> *results)
+    llvm::Type *vectorType = vectorFunction->getReturnType();
+    llvm::Type *pointerType = vectorType->getPointerTo();
+    llvm::Function *wrapper = llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                {pointerType, pointerType}, false),
+        llvm::Function::ExternalLinkage, "run", module.get());
+    llvm::IRBuilder<> builder(
+        llvm::BasicBlock::Create(context, "entry", wrapper));
+    llvm::Value *vector = builder.CreateLoad(vectorType, wrapper->getArg(0));
+    builder.CreateStore(builder.CreateCall(vectorFunction, {vector}),
+                        wrapper->getArg(1));
+    builder.CreateRetVoid();
+
+    EXPECT_FALSE(llvm::verifyModule(*module, &llvm::errs()));
+
+    std::string error;
+    std::unique_ptr<llvm::ExecutionEngine> engine(
+        llvm::EngineBuilder(std::move(module))
+            .setErrorStr(&error)
+            .setEngineKind(llvm::EngineKind::JIT)
+            .create());
+    EXPECT_TRUE(engine) << error;
+    if (!engine)
+      return false;
+
+    auto runFunction = reinterpret_cast<void (*)(const int32_t *, int32_t *)>(
+        engine->getFunctionAddress("run"));
+    alignas(16) int32_t input[Width];
+    alignas(16) int32_t output[Width];
+    std::copy(arguments, arguments + Width, input);
+    runFunction(input, output);
+    std::copy(output, output + Width, results);
+    return true;
+  }
+
+  static nlohmann::json leaf(nlohmann::json assignments,
+                             const std::string &target) {
+    return {{"parallel-assignments", assignments},
+            {"target-cutpoint", target}};
+  }
+
+  static nlohmann::json assign(const std::string &variable,
+                               nlohmann::json expression) {
+    return {{"variable", variable}, {"expression", expression}};
+  }
+
+  static nlohmann::json op(const std::string &type, nlohmann::json left,
+                           nlohmann::json right) {
+    return {{"type", type}, {"left-child", left}, {"right-child", right}};
+  }
+};
+
+TEST_F(VectorCodeGeneratorTest, SelectsTheLeafOfEveryLane) {
+  createSource(1);
+
+  // var0 = arg0 < 0 ? 0 - arg0 : arg0
+  nlohmann::json add = {
+      {"start-cutpoint", "entry"},
+      {"decision-diagram",
+       {{"condition", op("<", "arg0", "0")},
+        {"true-child",
+         leaf({assign("var0", op("-", "0", "arg0"))}, "end")},
+        {"false-child", leaf({assign("var0", "arg0")}, "end")}}}};
+
+  int32_t results[Width];
+  ASSERT_TRUE(run({add}, {-3, 5, 0, -2147483647}, results));
+  EXPECT_EQ(results[0], 3);
+  EXPECT_EQ(results[1], 5);
+  EXPECT_EQ(results[2], 0);
+  EXPECT_EQ(results[3], 2147483647);
+}
+
+TEST_F(VectorCodeGeneratorTest, LanesLeaveTheLoopIndependently) {
+  createSource(2);
+
+  // var0 = 0; var1 = arg0; while (var1 > 0) { var0 += var1; var1 -= 1; }
+  nlohmann::json entry = {
+      {"start-cutpoint", "entry"},
+      {"decision-diagram",
+       leaf({assign("var0", "0"), assign("var1", "arg0")}, "loop")}};
+  nlohmann::json loop = {
+      {"start-cutpoint", "loop"},
+      {"decision-diagram",
+       {{"condition", op(">", "var1", "0")},
+        {"true-child",
+         leaf({assign("var0", op("+", "var0", "var1")),
+               assign("var1", op("-", "var1", "1"))},
+              "loop")},
+        {"false-child", leaf({}, "end")}}}};
+
+  int32_t results[Width];
+  ASSERT_TRUE(run({entry, loop}, {0, 1, 10, -4}, results));
+  EXPECT_EQ(results[0], 0);
+  EXPECT_EQ(results[1], 1);
+  EXPECT_EQ(results[2], 55);
+  EXPECT_EQ(results[3], 0);
+}
+
+TEST_F(VectorCodeGeneratorTest, InactiveLeavesDoNotTrap) {
+  createSource(1);
+
+  // var0 = arg0 = 0 ? -1 : 100 / arg0, the division is computed for all lanes
+  nlohmann::json add = {
+      {"start-cutpoint", "entry"},
+      {"decision-diagram",
+       {{"condition", op("=", "arg0", "0")},
+        {"true-child", leaf({assign("var0", op("-", "0", "1"))}, "end")},
+        {"false-child",
+         leaf({assign("var0", op("/", "100", "arg0"))}, "end")}}}};
+
+  int32_t results[Width];
+  ASSERT_TRUE(run({add}, {0, 7, -50, 0}, results));
+  EXPECT_EQ(results[0], -1);
+  EXPECT_EQ(results[1], 14);
+  EXPECT_EQ(results[2], -2);
+  EXPECT_EQ(results[3], -1);
+}
+
+TEST_F(VectorCodeGeneratorTest, FunctionCallsAreNotVectorized) {
+  createSource(1);
+
+  nlohmann::json call = {{"type", "function-call"},
+                         {"function-name", "g"},
+                         {"function-arguments", {"arg0"}}};
+  nlohmann::json add = {{"start-cutpoint", "entry"},
+                        {"decision-diagram",
+                         leaf({assign("var0", call)}, "end")}};
+
+  int32_t results[Width];
+  EXPECT_FALSE(run({add}, {0, 0, 0, 0}, results));
+}
+
+} // namespace